@@ -58,6 +58,9 @@ typedef struct KeyNode {
    /* This is filled in by StartupKeys if it isn't already set. */
    int code;
 
+   /* Next binding in the same bucket of bindingHash. */
+   struct KeyNode *hashNext;
+
 } KeyNode;
 
 typedef struct LockNode {
@@ -70,18 +73,39 @@ static LockNode lockMods[] = {
    { XK_Num_Lock,    0 }
 };
 
+/* Size of the binding hash table (must be a power of two). */
+#define BINDING_HASH_SIZE 512
+
 static KeyNode *bindings[MC_COUNT];
 unsigned lockMask;
 
+/** Index of bindings by (context, state, code).
+ * While parsing, key codes are not yet known, so the key symbol is
+ * included in the hash. Once StartupBindings has looked up the codes,
+ * the table is rebuilt to be keyed on the code alone.
+ */
+static KeyNode *bindingHash[BINDING_HASH_SIZE];
+static char hashByCode;
+
 static unsigned int GetModifierMask(XModifierKeymap *modmap, KeySym key);
 static KeySym ParseKeyString(const char *str, const char* fileName, int line);
 static char ShouldGrab(ActionType key);
 static void GrabKey(KeyNode *np, Window win);
+static unsigned int GetBindingHash(MouseContextType context,
+                                   unsigned int state, int code,
+                                   KeySym symbol);
+static void InsertBindingHash(KeyNode *np);
+static KeyNode *FindBinding(MouseContextType context,
+                            unsigned int state, int code);
+static void RemoveDuplicates(const KeyNode *bp);
+static void AddBinding(KeyNode *np);
 
 /** Initialize binding data. */
 void InitializeBindings(void)
 {
    memset(bindings, 0, sizeof(bindings));
+   memset(bindingHash, 0, sizeof(bindingHash));
+   hashByCode = 0;
    lockMask = 0;
 }
 
@@ -126,6 +150,24 @@ void StartupBindings(void)
       }
 
    }
+
+   /* Index all bindings by code now that the codes are known.
+    * Different key symbols can map to the same code. The lists are
+    * newest first, so appending keeps the newest such binding first in
+    * its bucket where FindBinding will find it. */
+   memset(bindingHash, 0, sizeof(bindingHash));
+   hashByCode = 1;
+   for(x = 0; x < MC_COUNT; x++) {
+      for(np = bindings[x]; np; np = np->next) {
+         KeyNode **hpp = &bindingHash[GetBindingHash(np->context, np->state,
+                                                     np->code, NoSymbol)];
+         while(*hpp) {
+            hpp = &(*hpp)->hashNext;
+         }
+         np->hashNext = NULL;
+         *hpp = np;
+      }
+   }
 }
 
 /** Shutdown bindings. */
@@ -165,6 +207,48 @@ void DestroyBindings(void)
          bindings[i] = np;
       }
    }
+   memset(bindingHash, 0, sizeof(bindingHash));
+   hashByCode = 0;
+}
+
+/** Compute the bucket for a binding. */
+unsigned int GetBindingHash(MouseContextType context, unsigned int state,
+                            int code, KeySym symbol)
+{
+   unsigned long h = context;
+   h = h * 31 + state;
+   h = h * 31 + (unsigned long)code;
+   if(!hashByCode) {
+      h = h * 31 + (unsigned long)symbol;
+   }
+   h ^= h >> 11;
+   return (unsigned int)h & (BINDING_HASH_SIZE - 1);
+}
+
+/** Add a binding to the hash table. */
+void InsertBindingHash(KeyNode *np)
+{
+   const unsigned int index = GetBindingHash(np->context, np->state,
+                                             np->code, np->symbol);
+   np->hashNext = bindingHash[index];
+   bindingHash[index] = np;
+}
+
+/** Find the binding for an event.
+ * The state must already have the lock modifiers removed.
+ */
+KeyNode *FindBinding(MouseContextType context, unsigned int state, int code)
+{
+   KeyNode *np;
+   Assert(hashByCode);
+   np = bindingHash[GetBindingHash(context, state, code, NoSymbol)];
+   while(np) {
+      if(np->context == context && np->state == state && np->code == code) {
+         return np;
+      }
+      np = np->hashNext;
+   }
+   return NULL;
 }
 
 /** Grab a key. */
@@ -212,11 +296,9 @@ ActionType GetKey(MouseContextType context, unsigned state, int code)
    /* Mask off flags. */
    context &= MC_MASK;
 
-   /* Loop looking for a matching key binding. */
-   for(np = bindings[context]; np; np = np->next) {
-      if(np->state == state && np->code == code) {
-         return np->action;
-      }
+   np = FindBinding(context, state, code);
+   if(np) {
+      return np->action;
    }
 
    result.action = ACTION_NONE;
@@ -235,11 +317,9 @@ void RunKeyCommand(MouseContextType context, unsigned state, int code)
    /* Mask off flags. */
    context &= MC_MASK;
 
-   for(np = bindings[context]; np; np = np->next) {
-      if(np->state == state && np->code == code) {
-         RunCommand(np->command);
-         return;
-      }
+   np = FindBinding(context, state, code);
+   if(np) {
+      RunCommand(np->command);
    }
 }
 
@@ -254,13 +334,11 @@ void ShowKeyMenu(MouseContextType context, unsigned state, int code)
    /* Mask off flags. */
    context &= MC_MASK;
 
-   for(np = bindings[context]; np; np = np->next) {
-      if(np->state == state && np->code == code) {
-         const int button = GetRootMenuIndexFromString(np->command);
-         if(JLIKELY(button >= 0)) {
-            ShowRootMenu(button, -1, -1, 1);
-         }
-         return;
+   np = FindBinding(context, state, code);
+   if(np) {
+      const int button = GetRootMenuIndexFromString(np->command);
+      if(JLIKELY(button >= 0)) {
+         ShowRootMenu(button, -1, -1, 1);
       }
    }
 }
@@ -381,27 +459,48 @@ KeySym ParseKeyString(const char *str, const char* fileName, int line)
    return symbol;
 }
 
-/** Remove a binding. */
-void RemoveDuplicates(KeyNode *bp)
+/** Remove bindings with the same context, modifiers, and key or button
+ * as a new binding.
+ */
+void RemoveDuplicates(const KeyNode *bp)
 {
-   KeyNode **npp = &bindings[bp->context];
-   while(*npp) {
-      KeyNode *np = *npp;
-      if(   np != bp
+   const unsigned int index = GetBindingHash(bp->context, bp->state,
+                                             bp->code, bp->symbol);
+   KeyNode **hpp = &bindingHash[index];
+
+   Assert(!hashByCode);
+
+   while(*hpp) {
+      KeyNode *np = *hpp;
+      if(   np->context == bp->context
          && np->symbol == bp->symbol
          && np->state == bp->state
          && np->code == bp->code) {
+         KeyNode **npp = &bindings[np->context];
+         while(*npp != np) {
+            npp = &(*npp)->next;
+         }
          *npp = np->next;
+         *hpp = np->hashNext;
          if(np->command) {
             Release(np->command);
          }
          Release(np);
       } else {
-         npp = &np->next;
+         hpp = &np->hashNext;
       }
    }
 }
 
+/** Add a new binding, replacing any existing duplicates. */
+void AddBinding(KeyNode *np)
+{
+   RemoveDuplicates(np);
+   np->next = bindings[np->context];
+   bindings[np->context] = np;
+   InsertBindingHash(np);
+}
+
 /** Insert a key binding. */
 void InsertBinding(ActionType action, const char *modifiers,
                    const char *stroke, const char *code,
@@ -432,9 +531,6 @@ void InsertBinding(ActionType action, const char *modifiers,
                }
 
                np = Allocate(sizeof(KeyNode));
-               np->next = bindings[MC_NONE];
-               bindings[MC_NONE] = np;
-
                np->context = MC_NONE;
                np->action = action;
                np->action.extra = temp[offset] - '1';
@@ -442,7 +538,7 @@ void InsertBinding(ActionType action, const char *modifiers,
                np->symbol = sym;
                np->command = NULL;
                np->code = 0;
-               RemoveDuplicates(np);
+               AddBinding(np);
 
             }
 
@@ -458,30 +554,24 @@ void InsertBinding(ActionType action, const char *modifiers,
       }
 
       np = Allocate(sizeof(KeyNode));
-      np->next = bindings[MC_NONE];
-      bindings[MC_NONE] = np;
-
       np->context = MC_NONE;
       np->action = action;
       np->state = mask;
       np->symbol = sym;
       np->command = CopyString(command);
       np->code = 0;
-      RemoveDuplicates(np);
+      AddBinding(np);
 
    } else if(code && strlen(code) > 0) {
 
       np = Allocate(sizeof(KeyNode));
-      np->next = bindings[MC_NONE];
-      bindings[MC_NONE] = np;
-
       np->context = MC_NONE;
       np->action = action;
       np->state = mask;
       np->symbol = NoSymbol;
       np->command = CopyString(command);
       np->code = atoi(code);
-      RemoveDuplicates(np);
+      AddBinding(np);
 
    } else {
 
@@ -500,16 +590,13 @@ void InsertMouseBinding(
    const char *command)
 {
    KeyNode *np = Allocate(sizeof(KeyNode));
-   np->next = bindings[context];
-   bindings[context] = np;
-
    np->command = CopyString(command);
    np->action = action;
    np->state = ParseModifierString(mask);
    np->symbol = NoSymbol;
    np->code = button;
    np->context = context;
-   RemoveDuplicates(np);
+   AddBinding(np);
 }
 
 /** Validate key bindings. */
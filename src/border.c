@@ -269,8 +269,8 @@ void ResetBorder(const ClientNode *np)
    int width, height;
 
    if(np->parent == None) {
-      JXMoveResizeWindow(display, np->window, np->x, np->y,
-                         np->width, np->height);
+      JXMoveResizeWindow(display, np->window, GetClientFrameX(np, np->x),
+                         np->y, np->width, np->height);
       return;
    }
 
@@ -290,7 +290,8 @@ void ResetBorder(const ClientNode *np)
       JXMoveResizeWindow(display, np->window, west, north,
                          np->width, np->height);
    }
-   JXMoveResizeWindow(display, np->parent, np->x - west, np->y - north,
+   JXMoveResizeWindow(display, np->parent,
+                      GetClientFrameX(np, np->x - west), np->y - north,
                       width, height);
 
 #ifdef USE_SHAPE
@@ -25,6 +25,7 @@
 #include "timing.h"
 #include "grab.h"
 #include "desktop.h"
+#include "winmap.h"
 
 static ClientNode *activeClient;
 
@@ -36,6 +37,9 @@ static void MinimizeTransients(ClientNode *np, char lower);
 static void RestoreTransients(ClientNode *np, char raise);
 static void KillClientHandler(ClientNode *np);
 static void UnmapClient(ClientNode *np);
+static void SignalName(const TimeType *now, int x, int y, Window w,
+                       void *data);
+static void RedrawClientName(ClientNode *np, const TimeType *now);
 
 /** Load windows that are already mapped. */
 void StartupClients(void)
@@ -56,6 +60,7 @@ void StartupClients(void)
       nodes[x] = NULL;
       nodeTail[x] = NULL;
    }
+   CreateDesktopLists();
 
    /* Query client windows. */
    JXQueryTree(display, rootWindow, &rootReturn, &parentReturn,
@@ -90,6 +95,7 @@ void ShutdownClients(void)
          RemoveClient(nodeTail[x]);
       }
    }
+   DestroyDesktopLists();
 
 }
 
@@ -159,6 +165,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
    np->state.border = BORDER_DEFAULT;
    np->mouseContext = MC_NONE;
 
+   ReadPropertyDigests(np->window, np->digests);
    ReadClientInfo(np, alreadyMapped);
 
    if(!notOwner) {
@@ -182,6 +189,8 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
       nodeTail[np->state.layer] = np;
    }
    nodes[np->state.layer] = np;
+   UpdateDesktopList(np);
+   AddToFocusHistory(np);
 
    if(notOwner) {
       XSetWindowAttributes sattr;
@@ -205,7 +214,7 @@ ClientNode *AddClientWindow(Window w, char alreadyMapped, char notOwner)
 
    PlaceClient(np, alreadyMapped);
    ReparentClient(np);
-   XSaveContext(display, np->window, clientContext, (void*)np);
+   RegisterWindow(np->window, notOwner ? OWNER_CLIENT : OWNER_DIALOG, np);
 
    if(np->state.status & STAT_MAPPED) {
       JXMapWindow(display, np->window);
@@ -570,6 +579,7 @@ void SetClientSticky(ClientNode *np, char isSticky)
          for(tp = nodes[x]; tp; tp = tp->next) {
             if(tp == np || tp->owner == np->window) {
                tp->state.status |= STAT_STICKY;
+               UpdateDesktopList(tp);
                SetCardinalAtom(tp->window, ATOM_NET_WM_DESKTOP, ~0UL);
                WriteState(tp);
             }
@@ -584,6 +594,7 @@ void SetClientSticky(ClientNode *np, char isSticky)
          for(tp = nodes[x]; tp; tp = tp->next) {
             if(tp == np || tp->owner == np->window) {
                tp->state.status &= ~STAT_STICKY;
+               UpdateDesktopList(tp);
                WriteState(tp);
             }
          }
@@ -618,6 +629,7 @@ void SetClientDesktop(ClientNode *np, unsigned int desktop)
             if(tp == np || tp->owner == np->window) {
 
                tp->state.desktop = desktop;
+               UpdateDesktopList(tp);
 
                if(desktop == currentDesktop) {
                   ShowClient(tp);
@@ -644,7 +656,12 @@ void HideClient(ClientNode *np)
          activeClient = NULL;
       }
       np->state.status |= STAT_HIDDEN;
-      if(np->state.status & (STAT_MAPPED | STAT_SHADED)) {
+      if(settings.desktopHide != DHIDE_UNMAP) {
+         MoveClientFrame(np);
+         if(settings.desktopHide == DHIDE_ICONIC) {
+            WriteState(np);
+         }
+      } else if(np->state.status & (STAT_MAPPED | STAT_SHADED)) {
          if(np->parent != None) {
             JXUnmapWindow(display, np->parent);
          } else {
@@ -659,12 +676,20 @@ void ShowClient(ClientNode *np)
 {
    if(np->state.status & STAT_HIDDEN) {
       np->state.status &= ~STAT_HIDDEN;
+      if(settings.desktopHide != DHIDE_UNMAP) {
+         MoveClientFrame(np);
+         if(settings.desktopHide == DHIDE_ICONIC) {
+            WriteState(np);
+         }
+      }
       if(np->state.status & (STAT_MAPPED | STAT_SHADED)) {
          if(!(np->state.status & STAT_MINIMIZED)) {
-            if(np->parent != None) {
-               JXMapWindow(display, np->parent);
-            } else {
-               JXMapWindow(display, np->window);
+            if(settings.desktopHide == DHIDE_UNMAP) {
+               if(np->parent != None) {
+                  JXMapWindow(display, np->parent);
+               } else {
+                  JXMapWindow(display, np->window);
+               }
             }
             if(np->state.status & STAT_ACTIVE) {
                FocusClient(np);
@@ -674,6 +699,33 @@ void ShowClient(ClientNode *np)
    }
 }
 
+/** Get the x-coordinate for the frame of a client. */
+int GetClientFrameX(const ClientNode *np, int x)
+{
+   if(JUNLIKELY(settings.desktopHide != DHIDE_UNMAP)
+      && (np->state.status & STAT_HIDDEN)) {
+      /* Keep the window mapped, but out of view. */
+      int north, south, east, west;
+      GetBorderSize(&np->state, &north, &south, &east, &west);
+      return -2 * (np->width + east + west);
+   }
+   return x;
+}
+
+/** Move the frame of a client to its current location. */
+void MoveClientFrame(const ClientNode *np)
+{
+   if(np->parent != None) {
+      int north, south, east, west;
+      GetBorderSize(&np->state, &north, &south, &east, &west);
+      JXMoveWindow(display, np->parent,
+                   GetClientFrameX(np, np->x - west), np->y - north);
+   } else {
+      JXMoveWindow(display, np->window,
+                   GetClientFrameX(np, np->x), np->y);
+   }
+}
+
 /** Maximize a client window. */
 void MaximizeClient(ClientNode *np, MaxFlags flags)
 {
@@ -846,6 +898,7 @@ void FocusClient(ClientNode *np)
       }
       np->state.status |= STAT_ACTIVE;
       activeClient = np;
+      UpdateFocusHistory(np);
       if(!(np->state.status & STAT_OPACITY)) {
          SetOpacity(np, settings.activeClientOpacity, 0);
       }
@@ -1090,10 +1143,12 @@ void RestackClients(void)
 
    TrayType *tp;
    ClientNode *np;
+   ClientNode *walk;
    unsigned int layer, index;
    int trayCount;
    Window *stack;
    Window fw;
+   Window ww;
 
    if(JUNLIKELY(shouldExit)) {
       return;
@@ -1125,15 +1180,44 @@ void RestackClients(void)
       }
       index += 1;
    }
+
+   /* The client shown by a window walk goes on top of its layer since
+    * the layer lists are not reordered until the walk stops. */
+   walk = GetWalkClient();
+   ww = None;
+   if(walk && walk->window != fw) {
+      ww = walk->window;
+   }
+
    layer = LAST_LAYER;
    for(;;) {
 
+      if(ww != None && walk->state.layer == layer) {
+         for(np = nodes[layer]; np; np = np->next) {
+            if(np->owner == ww
+               && (np->state.status & (STAT_MAPPED | STAT_SHADED))
+               && !(np->state.status & STAT_HIDDEN)) {
+               stack[index] = np->parent != None ? np->parent : np->window;
+               index += 1;
+            }
+         }
+         if(    (walk->state.status & (STAT_MAPPED | STAT_SHADED))
+            && !(walk->state.status & STAT_HIDDEN)) {
+            stack[index] = walk->parent != None ? walk->parent : walk->window;
+            index += 1;
+         }
+      }
+
       for(np = nodes[layer]; np; np = np->next) {
          if(    (np->state.status & (STAT_MAPPED | STAT_SHADED))
             && !(np->state.status & STAT_HIDDEN)) {
             if(fw != None && (np->window == fw || np->owner == fw)) {
                continue;
             }
+            if(ww != None && walk->state.layer == layer
+               && (np->window == ww || np->owner == ww)) {
+               continue;
+            }
             if(np->parent != None) {
                stack[index] = np->parent;
             } else {
@@ -1197,6 +1281,8 @@ void RemoveClient(ClientNode *np)
    Assert(np->window != None);
 
    /* Remove this client from the client list */
+   RemoveFromFocusHistory(np);
+   RemovePagerThumbnail(np);
    if(np->next) {
       np->next->prev = np->prev;
    } else {
@@ -1207,15 +1293,19 @@ void RemoveClient(ClientNode *np)
    } else {
       nodes[np->state.layer] = np->next;
    }
+   RemoveFromDesktopList(np);
    clientCount -= 1;
-   XDeleteContext(display, np->window, clientContext);
+   UnregisterWindow(np->window);
    if(np->parent != None) {
-      XDeleteContext(display, np->parent, frameContext);
+      UnregisterWindow(np->parent);
    }
 
    if(np->state.status & STAT_URGENT) {
       UnregisterCallback(SignalUrgent, np);
    }
+   if(np->namePending) {
+      UnregisterCallback(SignalName, np);
+   }
 
    /* Make sure this client isn't active */
    if(activeClient == np && !shouldExit) {
@@ -1247,6 +1337,12 @@ void RemoveClient(ClientNode *np)
             && (np->state.status & (STAT_MINIMIZED | STAT_SHADED)))) {
          JXMapWindow(display, np->window);
       }
+      if((np->state.status & STAT_HIDDEN)
+         && settings.desktopHide == DHIDE_ICONIC) {
+         /* Don't leave the window iconic for the next window manager. */
+         np->state.status &= ~STAT_HIDDEN;
+         WriteState(np);
+      }
       JXUngrabButton(display, AnyButton, AnyModifier, np->window);
       JXReparentWindow(display, np->window, rootWindow, np->x, np->y);
       JXRemoveFromSaveSet(display, np->window);
@@ -1296,21 +1392,26 @@ ClientNode *GetActiveClient(void)
 /** Find a client by parent or window. */
 ClientNode *FindClient(Window w)
 {
-   ClientNode *np;
-   np = FindClientByWindow(w);
-   if(!np) {
-      np = FindClientByParent(w);
+   void *data;
+   switch(FindWindowOwner(w, &data)) {
+   case OWNER_CLIENT:
+   case OWNER_DIALOG:
+   case OWNER_FRAME:
+      return (ClientNode*)data;
+   default:
+      return NULL;
    }
-   return np;
 }
 
 /** Find a client by window. */
 ClientNode *FindClientByWindow(Window w)
 {
-   ClientNode *np;
-   if(!XFindContext(display, w, clientContext, (void*)&np)) {
-      return np;
-   } else {
+   void *data;
+   switch(FindWindowOwner(w, &data)) {
+   case OWNER_CLIENT:
+   case OWNER_DIALOG:
+      return (ClientNode*)data;
+   default:
       return NULL;
    }
 }
@@ -1318,9 +1419,9 @@ ClientNode *FindClientByWindow(Window w)
 /** Find a client by its frame window. */
 ClientNode *FindClientByParent(Window p)
 {
-   ClientNode *np;
-   if(!XFindContext(display, p, frameContext, (void*)&np)) {
-      return np;
+   void *data;
+   if(FindWindowOwner(p, &data) == OWNER_FRAME) {
+      return (ClientNode*)data;
    } else {
       return NULL;
    }
@@ -1334,6 +1435,12 @@ void ReparentClient(ClientNode *np)
    int attrMask;
    int x, y, width, height;
    int north, south, east, west;
+   char unmapped;
+
+   /* Hidden clients are unmapped by unmapping the frame if there is one
+    * and the client window otherwise. */
+   unmapped = (np->state.status & STAT_HIDDEN)
+            && settings.desktopHide == DHIDE_UNMAP;
 
    if((np->state.border & (BORDER_TITLE | BORDER_OUTLINE)) == 0) {
 
@@ -1341,8 +1448,15 @@ void ReparentClient(ClientNode *np)
          return;
       }
 
-      JXReparentWindow(display, np->window, rootWindow, np->x, np->y);
-      XDeleteContext(display, np->parent, frameContext);
+      /* Pager thumbnails are keyed by frame and hold resources for it. */
+      RemovePagerThumbnail(np);
+
+      JXReparentWindow(display, np->window, rootWindow,
+                       GetClientFrameX(np, np->x), np->y);
+      if(unmapped && (np->state.status & STAT_MAPPED)) {
+         JXUnmapWindow(display, np->window);
+      }
+      UnregisterWindow(np->parent);
       JXDestroyWindow(display, np->parent);
       np->parent = None;
 
@@ -1352,6 +1466,9 @@ void ReparentClient(ClientNode *np)
          return;
       }
 
+      /* Pager thumbnails are keyed by frame and hold resources for it. */
+      RemovePagerThumbnail(np);
+
       attrMask = 0;
 
       /* We can't use PointerMotionHint mask here since the exact location
@@ -1383,7 +1500,7 @@ void ReparentClient(ClientNode *np)
       width = np->width;
       height = np->height;
       GetBorderSize(&np->state, &north, &south, &east, &west);
-      x -= west;
+      x = GetClientFrameX(np, x - west);
       y -= north;
       width += east + west;
       height += north + south;
@@ -1392,7 +1509,7 @@ void ReparentClient(ClientNode *np)
       np->parent = JXCreateWindow(display, rootWindow, x, y, width, height,
                                   0, rootDepth, InputOutput,
                                   rootVisual, attrMask, &attr);
-      XSaveContext(display, np->parent, frameContext, (void*)np);
+      RegisterWindow(np->parent, OWNER_FRAME, np);
 
       JXSetWindowBorderWidth(display, np->window, 0);
 
@@ -1400,12 +1517,17 @@ void ReparentClient(ClientNode *np)
       JXReparentWindow(display, np->window, np->parent, west, north);
 
       if(np->state.status & STAT_MAPPED) {
-         JXMapWindow(display, np->parent);
+         if(unmapped) {
+            JXMapWindow(display, np->window);
+         } else {
+            JXMapWindow(display, np->parent);
+         }
       }
    }
 
+   /* Discard the unmap events caused by reparenting and hiding. */
    JXSync(display, False);
-   JXCheckTypedWindowEvent(display, np->window, UnmapNotify, &event);
+   while(JXCheckTypedWindowEvent(display, np->window, UnmapNotify, &event));
 
 }
 
@@ -1494,6 +1616,49 @@ void SignalUrgent(const TimeType *now, int x, int y, Window w, void *data)
 
 }
 
+/** Update the name of a client after its name property changed. */
+void UpdateClientName(ClientNode *np)
+{
+   TimeType now;
+
+   /* The timer will pick up the latest name. */
+   if(np->namePending) {
+      return;
+   }
+
+   GetCurrentTime(&now);
+   if(GetTimeDifference(&now, &np->nameTime) < TITLE_UPDATE_DELAY) {
+      np->namePending = 1;
+      RegisterCallback(TITLE_UPDATE_DELAY, SignalName, np);
+   } else {
+      RedrawClientName(np, &now);
+   }
+}
+
+/** Callback for deferred name updates. */
+void SignalName(const TimeType *now, int x, int y, Window w, void *data)
+{
+   ClientNode *np = (ClientNode*)data;
+   if(GetTimeDifference(now, &np->nameTime) >= TITLE_UPDATE_DELAY) {
+      np->namePending = 0;
+      UnregisterCallback(SignalName, np);
+      RedrawClientName(np, now);
+   }
+}
+
+/** Read the name of a client and redraw if it changed. */
+void RedrawClientName(ClientNode *np, const TimeType *now)
+{
+   const unsigned int oldHash = np->nameHash;
+   ReadWMName(np);
+   if(np->nameHash != oldHash) {
+      np->nameTime = *now;
+      DrawBorder(np);
+      RequireTaskUpdate();
+      RequirePagerUpdate();
+   }
+}
+
 /** Unmap a client window and consume the UnmapNotify event. */
 void UnmapClient(ClientNode *np)
 {
@@ -13,6 +13,7 @@
 #include "main.h"
 #include "border.h"
 #include "hint.h"
+#include "timing.h"
 
 struct TimeType;
 
@@ -153,12 +154,18 @@ typedef struct ClientNode {
    NewColors tcolors;         /**< Title- and outline colors */
 
    char *name;                /**< Name of this window for display. */
+   unsigned int nameHash;     /**< Hash of the name (0 if no name). */
+   TimeType nameTime;         /**< Time the name was last redrawn. */
+   char namePending;          /**< Set if a name update is deferred. */
    char *instanceName;        /**< Name of this window for properties. */
    char *className;           /**< Name of the window class. */
    char *clientName;         /**< Name of the client machine. */
 
    ClientState state;         /**< Window state. */
 
+   /** Digests of properties used to drop changes that are no-ops. */
+   PropertyDigest digests[DIGEST_COUNT];
+
    double titlewidth;         /**< relative title width. */
    double titlexpos;          /**< relative title position. */
 
@@ -172,6 +179,13 @@ typedef struct ClientNode {
    struct ClientNode *prev;   /**< The previous client in this layer. */
    struct ClientNode *next;   /**< The next client in this layer. */
 
+   struct ClientNode **deskHead; /**< Desktop list head (NULL if none). */
+   struct ClientNode *deskPrev;  /**< The previous client on this desktop. */
+   struct ClientNode *deskNext;  /**< The next client on this desktop. */
+
+   struct ClientNode *focusPrev; /**< More recently focused client. */
+   struct ClientNode *focusNext; /**< Less recently focused client. */
+
 } ClientNode;
 
 /** The number of clients (maintained in client.c). */
@@ -334,6 +348,19 @@ void HideClient(ClientNode *np);
  */
 void ShowClient(ClientNode *np);
 
+/** Get the x-coordinate for the frame of a client.
+ * Clients hidden without being unmapped are placed off-screen.
+ * @param np The client.
+ * @param x The x-coordinate of the frame if the client is visible.
+ * @return The x-coordinate to use for the frame.
+ */
+int GetClientFrameX(const ClientNode *np, int x);
+
+/** Move the frame of a client to its current location.
+ * @param np The client.
+ */
+void MoveClientFrame(const ClientNode *np);
+
 /** Update a client's colormap.
  * @param np The client.
  */
@@ -359,6 +386,14 @@ void SendConfigureEvent(ClientNode *np);
  */
 void SendClientMessage(Window w, AtomType type, AtomType message);
 
+/** Update the name of a client after its name property changed.
+ * Borders, the task list and the pager are only redrawn if the name
+ * changed, and at most once every TITLE_UPDATE_DELAY milliseconds per
+ * client; faster updates are deferred to a timer.
+ * @param np The client.
+ */
+void UpdateClientName(ClientNode *np);
+
 /** Update callback for clients with the urgency hint set. */
 void SignalUrgent(const struct TimeType *now, int x, int y, Window w,
                   void *data);
@@ -14,16 +14,25 @@
 #include "event.h"
 #include "tray.h"
 #include "settings.h"
+#include "screen.h"
 
 ClientNode *nodes[LAYER_COUNT];
 ClientNode *nodeTail[LAYER_COUNT];
+ClientNode **desktopNodes = NULL;
 
-static Window *windowStack = NULL;  /**< Image of the window stack. */
-static int windowStackSize = 0;     /**< Size of the image. */
-static int windowStackCurrent = 0;  /**< Current location in the image. */
+/** Clients in focus order, most recently focused first. */
+static ClientNode *focusHead = NULL;
+static ClientNode *focusTail = NULL;
+
+static ClientNode *walkClient = NULL; /**< Current client in the walk. */
+static int walkScreen = -1;         /**< Screen being walked (-1 for all). */
 static char walkingWindows = 0;     /**< Are we walking windows? */
 static char wasMinimized = 0;       /**< Was the current window minimized? */
 
+static ClientNode *GetNextWalkClient(const ClientNode *np, char forward);
+static ClientNode *GetTopClient(void);
+static char ShouldWalk(const ClientNode *np);
+
 /** Determine if a client is allowed focus. */
 char ShouldFocus(const ClientNode *np, char current)
 {
@@ -53,6 +62,90 @@ char ShouldFocus(const ClientNode *np, char current)
 
 }
 
+/** Create the per-desktop client lists. */
+void CreateDesktopLists(void)
+{
+   const unsigned int count = settings.desktopCount + 1;
+   Assert(desktopNodes == NULL);
+   desktopNodes = Allocate(sizeof(ClientNode*) * count);
+   memset(desktopNodes, 0, sizeof(ClientNode*) * count);
+}
+
+/** Destroy the per-desktop client lists. */
+void DestroyDesktopLists(void)
+{
+   if(desktopNodes) {
+      Release(desktopNodes);
+      desktopNodes = NULL;
+   }
+}
+
+/** Move a client to the desktop list matching its state. */
+void UpdateDesktopList(ClientNode *np)
+{
+
+   ClientNode **head;
+
+   if(np->state.status & STAT_STICKY) {
+      head = &desktopNodes[settings.desktopCount];
+   } else {
+      Assert(np->state.desktop < settings.desktopCount);
+      head = &desktopNodes[np->state.desktop];
+   }
+   if(np->deskHead == head) {
+      return;
+   }
+
+   RemoveFromDesktopList(np);
+   np->deskHead = head;
+   np->deskPrev = NULL;
+   np->deskNext = *head;
+   if(np->deskNext) {
+      np->deskNext->deskPrev = np;
+   }
+   *head = np;
+
+}
+
+/** Remove a client from its desktop list. */
+void RemoveFromDesktopList(ClientNode *np)
+{
+   if(np->deskHead) {
+      if(np->deskPrev) {
+         np->deskPrev->deskNext = np->deskNext;
+      } else {
+         Assert(*np->deskHead == np);
+         *np->deskHead = np->deskNext;
+      }
+      if(np->deskNext) {
+         np->deskNext->deskPrev = np->deskPrev;
+      }
+      np->deskHead = NULL;
+      np->deskPrev = NULL;
+      np->deskNext = NULL;
+   }
+}
+
+/** Get the first client visible on a desktop. */
+ClientNode *GetFirstDesktopClient(unsigned int desktop)
+{
+   if(desktopNodes[desktop]) {
+      return desktopNodes[desktop];
+   }
+   return GetStickyClients();
+}
+
+/** Get the next client visible on the same desktop. */
+ClientNode *GetNextDesktopClient(const ClientNode *np)
+{
+   if(np->deskNext) {
+      return np->deskNext;
+   } else if(np->deskHead != &desktopNodes[settings.desktopCount]) {
+      return GetStickyClients();
+   }
+   return NULL;
+}
+
 /** Start walking windows in client list order. */
 void StartWindowWalk(void)
 {
@@ -62,55 +155,174 @@ void StartWindowWalk(void)
    walkingWindows = 1;
 }
 
-/** Start walking the window stack. */
-void StartWindowStackWalk(void)
+/** Add a new client to the end of the focus history. */
+void AddToFocusHistory(ClientNode *np)
 {
+   np->focusNext = NULL;
+   np->focusPrev = focusTail;
+   if(focusTail) {
+      focusTail->focusNext = np;
+   } else {
+      focusHead = np;
+   }
+   focusTail = np;
+}
 
-   /* Get an image of the window stack.
-    * Here we get the Window IDs rather than client pointers so
-    * clients can be added/removed without disrupting the stack walk.
-    */
+/** Remove a client from the focus history. */
+void RemoveFromFocusHistory(ClientNode *np)
+{
+   /* Move the window walk off of this client. */
+   if(walkClient == np) {
+      walkClient = GetNextWalkClient(np, 0);
+      if(walkClient == np) {
+         walkClient = NULL;
+      }
+      wasMinimized = 0;
+   }
 
-   ClientNode *np;
-   int layer;
-   int count;
+   if(np->focusPrev) {
+      np->focusPrev->focusNext = np->focusNext;
+   } else {
+      focusHead = np->focusNext;
+   }
+   if(np->focusNext) {
+      np->focusNext->focusPrev = np->focusPrev;
+   } else {
+      focusTail = np->focusPrev;
+   }
+   np->focusPrev = NULL;
+   np->focusNext = NULL;
+}
 
-   /* If we are already walking the stack, just return. */
-   if(windowStack != NULL) {
+/** Move a client to the front of the focus history.
+ * Focus changes while walking windows are not recorded; the client
+ * chosen by the walk is recorded when the walk stops.
+ */
+void UpdateFocusHistory(ClientNode *np)
+{
+   if(walkingWindows || np == focusHead) {
       return;
    }
+   np->focusPrev->focusNext = np->focusNext;
+   if(np->focusNext) {
+      np->focusNext->focusPrev = np->focusPrev;
+   } else {
+      focusTail = np->focusPrev;
+   }
+   np->focusPrev = NULL;
+   np->focusNext = focusHead;
+   focusHead->focusPrev = np;
+   focusHead = np;
+}
 
-   /* First determine how much space to allocate for windows. */
-   count = 0;
-   for(layer = LAST_LAYER; layer >= FIRST_LAYER; layer--) {
-      for(np = nodes[layer]; np; np = np->next) {
-         if(ShouldFocus(np, 1)) {
-            ++count;
-         }
+/** Get the next client in walk order, wrapping around at the end.
+ * The layer lists are not reordered while walking (see WalkWindowStack),
+ * so a stacking order walk can follow them directly.
+ */
+ClientNode *GetNextWalkClient(const ClientNode *np, char forward)
+{
+   int layer;
+
+   if(settings.walkOrder == WALK_HISTORY) {
+      if(forward) {
+         return np->focusNext ? np->focusNext : focusHead;
+      } else {
+         return np->focusPrev ? np->focusPrev : focusTail;
       }
    }
 
-   /* If there were no windows to walk, don't even start. */
-   if(count == 0) {
-      return;
+   /* Stacking order, top to bottom. */
+   if(forward) {
+      if(np->next) {
+         return np->next;
+      }
+      for(layer = np->state.layer - 1; layer >= FIRST_LAYER; layer--) {
+         if(nodes[layer]) {
+            return nodes[layer];
+         }
+      }
+      return GetTopClient();
+   } else {
+      if(np->prev) {
+         return np->prev;
+      }
+      for(layer = np->state.layer + 1; layer <= LAST_LAYER; layer++) {
+         if(nodeTail[layer]) {
+            return nodeTail[layer];
+         }
+      }
+      for(layer = FIRST_LAYER; layer <= LAST_LAYER; layer++) {
+         if(nodeTail[layer]) {
+            return nodeTail[layer];
+         }
+      }
+      return NULL;
    }
+}
 
-   /* Allocate space for the windows. */
-   windowStack = Allocate(sizeof(Window) * count);
-
-   /* Copy windows into the array. */
-   windowStackSize = 0;
+/** Get the client at the top of the stacking order. */
+ClientNode *GetTopClient(void)
+{
+   int layer;
    for(layer = LAST_LAYER; layer >= FIRST_LAYER; layer--) {
-      for(np = nodes[layer]; np; np = np->next) {
-         if(ShouldFocus(np, 1)) {
-            windowStack[windowStackSize++] = np->window;
-         }
+      if(nodes[layer]) {
+         return nodes[layer];
       }
    }
+   return NULL;
+}
+
+/** Determine if a client should be visited when walking windows. */
+char ShouldWalk(const ClientNode *np)
+{
+   if(!ShouldFocus(np, 1)) {
+      return 0;
+   }
+   if(walkScreen >= 0) {
+      const ScreenType *sp = GetCurrentScreen(np->x + np->width / 2,
+                                              np->y + np->height / 2);
+      if(sp->index != walkScreen) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/** Start walking the window stack. */
+void StartWindowStackWalk(void)
+{
+
+   ClientNode *np;
+
+   /* If we are already walking the stack, just return. */
+   if(walkClient != NULL) {
+      return;
+   }
 
-   Assert(windowStackSize == count);
+   if(settings.walkScope == WSCOPE_SCREEN) {
+      walkScreen = GetMouseScreen()->index;
+   } else {
+      walkScreen = -1;
+   }
 
-   windowStackCurrent = 0;
+   /* Start at the first client to walk. */
+   if(settings.walkOrder == WALK_HISTORY) {
+      np = focusHead;
+   } else {
+      np = GetTopClient();
+   }
+   if(np == NULL) {
+      return;
+   }
+   walkClient = np;
+   while(!ShouldWalk(walkClient)) {
+      walkClient = GetNextWalkClient(walkClient, 1);
+      if(walkClient == np) {
+         /* There are no windows to walk, so don't even start. */
+         walkClient = NULL;
+         return;
+      }
+   }
 
    JXGrabKeyboard(display, rootWindow, False, GrabModeAsync,
                   GrabModeAsync, CurrentTime);
@@ -128,50 +340,40 @@ void WalkWindowStack(char forward)
 
    ClientNode *np;
 
-   if(windowStack != NULL) {
-      int x;
+   if(walkClient != NULL) {
 
       if(wasMinimized) {
-         np = FindClientByWindow(windowStack[windowStackCurrent]);
-         if(np) {
-            MinimizeClient(np, 1);
-         }
+         MinimizeClient(walkClient, 0);
       }
 
       /* Loop until we either raise a window or go through them all. */
-      for(x = 0; x < windowStackSize; x++) {
+      np = walkClient;
+      for(;;) {
 
          /* Move to the next/previous window (wrap if needed). */
-         if(forward) {
-             windowStackCurrent = (windowStackCurrent + 1) % windowStackSize;
-         } else {
-             if(windowStackCurrent == 0) {
-                 windowStackCurrent = windowStackSize;
-             }
-             windowStackCurrent -= 1;
+         np = GetNextWalkClient(np, forward);
+         if(np == NULL || np == walkClient) {
+            break;
          }
 
-         /* Look up the window. */
-         np = FindClientByWindow(windowStack[windowStackCurrent]);
-
-         /* Skip this window if it no longer exists or is currently in
-          * a state that doesn't allow focus.
+         /* Skip this window if it is currently in a state that
+          * doesn't allow focus.
           */
-         if(np == NULL || !ShouldFocus(np, 1)
-            || (np->state.status & STAT_ACTIVE)) {
+         if(!ShouldWalk(np) || (np->state.status & STAT_ACTIVE)) {
             continue;
          }
 
          /* Show the window.
-          * Only when the walk completes do we update the stacking order. */
-         RestackClients();
+          * Only when the walk completes do we update the stacking order;
+          * until then RestackClients shows the walk client on top. */
+         walkClient = np;
          if(np->state.status & STAT_MINIMIZED) {
-            RestoreClient(np, 1);
+            RestoreClient(np, 0);
             wasMinimized = 1;
          } else {
             wasMinimized = 0;
          }
-         JXRaiseWindow(display, np->parent ? np->parent : np->window);
+         RestackClients();
          FocusClient(np);
          break;
 
@@ -187,35 +389,34 @@ void StopWindowWalk(void)
 
    ClientNode *np;
 
-   /* Raise the selected window and free the window array. */
-   if(windowStack != NULL) {
-
-      /* Look up the current window. */
-      np = FindClientByWindow(windowStack[windowStackCurrent]);
-      if(np) {
-         if(np->state.status & STAT_MINIMIZED) {
-            RestoreClient(np, 1);
-         } else {
-            RaiseClient(np);
-         }
+   /* Raise the selected window. */
+   if(walkClient != NULL) {
+      if(walkClient->state.status & STAT_MINIMIZED) {
+         RestoreClient(walkClient, 1);
+      } else {
+         RaiseClient(walkClient);
       }
-
-      Release(windowStack);
-      windowStack = NULL;
-
-      windowStackSize = 0;
-      windowStackCurrent = 0;
-
+      walkClient = NULL;
    }
 
    if(walkingWindows) {
       JXUngrabKeyboard(display, CurrentTime);
       LowerTrays();
       walkingWindows = 0;
+      np = GetActiveClient();
+      if(np) {
+         UpdateFocusHistory(np);
+      }
    }
 
 }
 
+/** Get the client shown by the window walk (NULL if not walking). */
+ClientNode *GetWalkClient(void)
+{
+   return walkClient;
+}
+
 /** Focus the next client in the stacking order. */
 void FocusNextStacked(ClientNode *np)
 {
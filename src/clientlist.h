@@ -20,6 +20,19 @@ extern struct ClientNode *nodes[LAYER_COUNT];
 /** Client windows in linked lists for each layer (pointer to the tail). */
 extern struct ClientNode *nodeTail[LAYER_COUNT];
 
+/** Client windows in linked lists for each desktop.
+ * The list after the last desktop holds sticky clients.
+ */
+extern struct ClientNode **desktopNodes;
+
+/** Get the non-sticky clients on a desktop.
+ * The list is linked through deskNext.
+ */
+#define GetDesktopClients( d ) (desktopNodes[d])
+
+/** Get the sticky clients (linked through deskNext). */
+#define GetStickyClients() (desktopNodes[settings.desktopCount])
+
 /** Determine if a client is on the current desktop.
  * @param np The client.
  * @return 1 if on the current desktop, 0 otherwise.
@@ -35,6 +48,53 @@ extern struct ClientNode *nodeTail[LAYER_COUNT];
  */
 char ShouldFocus(const struct ClientNode *np, char current);
 
+/** Create the per-desktop client lists. */
+void CreateDesktopLists(void);
+
+/** Destroy the per-desktop client lists.
+ * All clients must be removed first.
+ */
+void DestroyDesktopLists(void);
+
+/** Move a client to the desktop list matching its state.
+ * This must be called whenever the desktop or sticky status changes.
+ * @param np The client.
+ */
+void UpdateDesktopList(struct ClientNode *np);
+
+/** Remove a client from its desktop list.
+ * @param np The client.
+ */
+void RemoveFromDesktopList(struct ClientNode *np);
+
+/** Get the first client visible on a desktop (including sticky clients).
+ * @param desktop The desktop.
+ * @return The first client or NULL if there are none.
+ */
+struct ClientNode *GetFirstDesktopClient(unsigned int desktop);
+
+/** Get the next client visible on the same desktop.
+ * Sticky clients follow the clients on the desktop.
+ * @param np The current client.
+ * @return The next client or NULL if there are no more.
+ */
+struct ClientNode *GetNextDesktopClient(const struct ClientNode *np);
+
+/** Add a new client to the focus history.
+ * @param np The client.
+ */
+void AddToFocusHistory(struct ClientNode *np);
+
+/** Remove a client from the focus history.
+ * @param np The client.
+ */
+void RemoveFromFocusHistory(struct ClientNode *np);
+
+/** Record that a client received the focus.
+ * @param np The client.
+ */
+void UpdateFocusHistory(struct ClientNode *np);
+
 /** Start walking the window client list. */
 void StartWindowWalk(void);
 
@@ -47,6 +107,13 @@ void WalkWindowStack(char forward);
 /** Stop walking the window stack or client list. */
 void StopWindowWalk(void);
 
+/** Get the client shown by the window walk.
+ * The walk does not change the stacking order until it stops, so this
+ * client is shown above the rest of its layer in the meantime.
+ * @return The client or NULL if not walking.
+ */
+struct ClientNode *GetWalkClient(void);
+
 /** Set the keyboard focus to the next client.
  * This is used to focus the next client in the stacking order.
  * @param np The client before the client to focus.
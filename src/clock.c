@@ -287,7 +287,7 @@ void DrawClock(ClockType *clk, const TimeType *now)
    /**< Resize clock if width of time/date string bigger than component width */
    if (maxTokenWidth > cp->width) {
       clk->cp->requestedWidth = maxTokenWidth + CLOCK_BORDER_SIZE * 2;
-      ResizeTray(clk->cp->tray);
+      ResizeTrayComponent(clk->cp);
    }
 
    sheight = GetStringHeight(FONT_CLOCK);
@@ -0,0 +1,358 @@
+/**
+ * @file configcache.c
+ *
+ * @brief Persistent cache of tokenized configuration files.
+ *
+ * The token trees of the configuration file and its includes are stored
+ * in a single file under $XDG_CACHE_HOME/jwm (or ~/.cache/jwm). The file
+ * is mapped while the configuration is parsed and cached tokens point
+ * directly into the mapping. Entries are keyed by the expanded file name
+ * and its inode, size, and modification and change times (with
+ * nanoseconds where available), so editing any file in the set only
+ * causes that file to be tokenized again. Files modified in the last
+ * second are not cached since a further edit in the same timestamp
+ * tick could go unnoticed. The cache file is rewritten
+ * after parsing if anything changed and only holds the files used by
+ * the last parse.
+ *
+ * Output of "exec:" includes is never cached. Files that produced
+ * warnings are not cached either so the warnings are shown every time.
+ *
+ * File layout (native byte order; the cache is local to the machine):
+ *  - ConfigCacheHeader
+ *  - ConfigCacheEntry[count]
+ *  - NUL-terminated file names
+ *  - Saved token trees (see SaveTokens), each aligned to 8 bytes
+ *
+ */
+
+#include "jwm.h"
+#include "configcache.h"
+#include "lex.h"
+#include "misc.h"
+#include "error.h"
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/** Identifies a cache file; change the version if the layout changes. */
+static const char CACHE_MAGIC[8] = "JWMCFGC";
+#define CACHE_VERSION 2
+
+typedef struct ConfigCacheHeader {
+   char magic[8];
+   unsigned int version;
+   unsigned int entrySize;    /**< sizeof(ConfigCacheEntry). */
+   unsigned int count;        /**< Number of entries. */
+   unsigned int reserved;
+} ConfigCacheHeader;
+
+typedef struct ConfigCacheEntry {
+   FileKey key;               /**< The version of the file. */
+   unsigned int nameOffset;   /**< Offset of the file name. */
+   unsigned int dataOffset;   /**< Offset of the saved tokens. */
+   unsigned int dataSize;     /**< Size of the saved tokens. */
+   unsigned int reserved;
+} ConfigCacheEntry;
+
+/** A file used by the current parse. */
+typedef struct PendingConfig {
+   ConfigCacheEntry entry;
+   const char *name;
+   const char *data;
+   char mapped;               /**< Set if name and data are in the cache. */
+   struct PendingConfig *next;
+} PendingConfig;
+
+static char *cachePath = NULL;
+static char *cacheData = NULL;
+static size_t cacheSize = 0;
+static const ConfigCacheEntry *cacheEntries = NULL;
+static unsigned int cacheCount = 0;
+
+static PendingConfig *pending = NULL;
+static PendingConfig *pendingTail = NULL;
+static char cacheChanged = 0;
+
+static void MapCache(void);
+static char ValidateCache(void);
+static PendingConfig *AddPending(const char *path, const struct stat *st);
+static void WriteConfigCache(void);
+
+/** Open the configuration cache. */
+void OpenConfigCache(void)
+{
+   cachePath = GetCachePath("config");
+   cacheChanged = 0;
+   MapCache();
+}
+
+/** Close the configuration cache. */
+void CloseConfigCache(void)
+{
+   unsigned int count;
+   PendingConfig *pp;
+
+   if(!cachePath) {
+      return;
+   }
+
+   /* Rewrite the file if a file changed or is no longer used. */
+   count = 0;
+   for(pp = pending; pp; pp = pp->next) {
+      count += 1;
+   }
+   if(cacheChanged || (pending && count != cacheCount)) {
+      WriteConfigCache();
+   }
+
+   while(pending) {
+      pp = pending->next;
+      if(!pending->mapped) {
+         char *name = (char*)pending->name;
+         char *data = (char*)pending->data;
+         Release(name);
+         Release(data);
+      }
+      Release(pending);
+      pending = pp;
+   }
+   pendingTail = NULL;
+
+   if(cacheData) {
+      munmap(cacheData, cacheSize);
+      cacheData = NULL;
+   }
+   cacheSize = 0;
+   cacheEntries = NULL;
+   cacheCount = 0;
+   Release(cachePath);
+   cachePath = NULL;
+}
+
+/** Remove the cache file. */
+void ClearConfigCache(void)
+{
+   char *path = GetCachePath("config");
+   if(path) {
+      if(unlink(path) < 0 && errno != ENOENT) {
+         Warning(_("could not remove %s: %s"), path, strerror(errno));
+      }
+      Release(path);
+   }
+}
+
+/** Map the cache file. */
+void MapCache(void)
+{
+   struct stat st;
+   void *data;
+   int fd;
+
+   if(!cachePath) {
+      return;
+   }
+   fd = open(cachePath, O_RDONLY);
+   if(fd < 0) {
+      return;
+   }
+   if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ConfigCacheHeader)) {
+      close(fd);
+      return;
+   }
+   data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(data == MAP_FAILED) {
+      return;
+   }
+   cacheData = data;
+   cacheSize = st.st_size;
+   if(!ValidateCache()) {
+      Debug("ignoring invalid configuration cache %s", cachePath);
+      munmap(cacheData, cacheSize);
+      cacheData = NULL;
+      cacheSize = 0;
+      cacheEntries = NULL;
+      cacheCount = 0;
+   }
+}
+
+/** Check that the mapped cache file is well-formed.
+ * The saved tokens are checked by LoadTokens.
+ */
+char ValidateCache(void)
+{
+   const ConfigCacheHeader *header = (const ConfigCacheHeader*)cacheData;
+   unsigned int x;
+
+   if(memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC))
+      || header->version != CACHE_VERSION
+      || header->entrySize != sizeof(ConfigCacheEntry)) {
+      return 0;
+   }
+   if(header->count > (cacheSize - sizeof(ConfigCacheHeader))
+                      / sizeof(ConfigCacheEntry)) {
+      return 0;
+   }
+   cacheEntries = (const ConfigCacheEntry*)
+                  (cacheData + sizeof(ConfigCacheHeader));
+   cacheCount = header->count;
+   for(x = 0; x < cacheCount; x++) {
+      const ConfigCacheEntry *ep = &cacheEntries[x];
+      if(ep->nameOffset >= cacheSize
+         || !memchr(cacheData + ep->nameOffset, 0,
+                    cacheSize - ep->nameOffset)) {
+         return 0;
+      }
+      if(ep->dataOffset > cacheSize
+         || ep->dataSize > cacheSize - ep->dataOffset
+         || (ep->dataOffset & 7) != 0) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/** Add a file to the list of files used by this parse.
+ * @return The new entry or NULL if the file is already listed.
+ */
+PendingConfig *AddPending(const char *path, const struct stat *st)
+{
+   PendingConfig *pp;
+   for(pp = pending; pp; pp = pp->next) {
+      if(!strcmp(pp->name, path)) {
+         return NULL;
+      }
+   }
+   pp = Allocate(sizeof(PendingConfig));
+   memset(&pp->entry, 0, sizeof(pp->entry));
+   GetFileKey(st, &pp->entry.key);
+   pp->name = NULL;
+   pp->data = NULL;
+   pp->mapped = 0;
+   pp->next = NULL;
+   if(pendingTail) {
+      pendingTail->next = pp;
+   } else {
+      pending = pp;
+   }
+   pendingTail = pp;
+   return pp;
+}
+
+/** Look up the tokens of a configuration file in the cache. */
+TokenNode *LoadCachedConfig(const char *path, const struct stat *st,
+                            const char *fileName)
+{
+   FileKey key;
+   unsigned int x;
+
+   if(!cacheData) {
+      return NULL;
+   }
+   GetFileKey(st, &key);
+   for(x = 0; x < cacheCount; x++) {
+      const ConfigCacheEntry *ep = &cacheEntries[x];
+      if(!memcmp(&ep->key, &key, sizeof(key))
+         && !strcmp(path, cacheData + ep->nameOffset)) {
+         const char *data = cacheData + ep->dataOffset;
+         TokenNode *tokens = LoadTokens(data, ep->dataSize, fileName);
+         if(JLIKELY(tokens)) {
+            PendingConfig *pp = AddPending(path, st);
+            if(pp) {
+               pp->entry.dataSize = ep->dataSize;
+               pp->name = cacheData + ep->nameOffset;
+               pp->data = data;
+               pp->mapped = 1;
+            }
+         }
+         return tokens;
+      }
+   }
+   return NULL;
+}
+
+/** Add the tokens of a configuration file to the cache. */
+void CacheConfig(const char *path, const struct stat *st,
+                 const TokenNode *tokens)
+{
+   PendingConfig *pp;
+
+   if(!cachePath || !tokens || GetTokenizeWarnings() > 0) {
+      return;
+   }
+   if(IsFileRecent(st)) {
+      return;
+   }
+   pp = AddPending(path, st);
+   if(pp) {
+      pp->name = CopyString(path);
+      pp->data = SaveTokens(tokens, &pp->entry.dataSize);
+      cacheChanged = 1;
+   }
+}
+
+/** Write the cache file with the files used by this parse. */
+void WriteConfigCache(void)
+{
+   static const char PADDING[8] = { 0 };
+   ConfigCacheHeader header;
+   PendingConfig *pp;
+   unsigned int count;
+   unsigned int nameOffset;
+   unsigned int dataOffset;
+   char *tempPath;
+   FILE *fd;
+
+   /* Assign offsets. */
+   count = 0;
+   for(pp = pending; pp; pp = pp->next) {
+      count += 1;
+   }
+   nameOffset = sizeof(ConfigCacheHeader) + count * sizeof(ConfigCacheEntry);
+   dataOffset = nameOffset;
+   for(pp = pending; pp; pp = pp->next) {
+      dataOffset += strlen(pp->name) + 1;
+   }
+   for(pp = pending; pp; pp = pp->next) {
+      pp->entry.nameOffset = nameOffset;
+      nameOffset += strlen(pp->name) + 1;
+      dataOffset = (dataOffset + 7) & ~7U;
+      pp->entry.dataOffset = dataOffset;
+      dataOffset += pp->entry.dataSize;
+   }
+
+   /* Write to a temporary file and rename it into place.
+    * The old file stays mapped until we are done with it. */
+   fd = CreateReplacement(cachePath, &tempPath);
+   if(JUNLIKELY(!fd)) {
+      Debug("could not write configuration cache %s", cachePath);
+      return;
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+   header.version = CACHE_VERSION;
+   header.entrySize = sizeof(ConfigCacheEntry);
+   header.count = count;
+   fwrite(&header, sizeof(header), 1, fd);
+   for(pp = pending; pp; pp = pp->next) {
+      fwrite(&pp->entry, sizeof(ConfigCacheEntry), 1, fd);
+   }
+   for(pp = pending; pp; pp = pp->next) {
+      fwrite(pp->name, strlen(pp->name) + 1, 1, fd);
+   }
+   for(pp = pending; pp; pp = pp->next) {
+      const long offset = ftell(fd);
+      fwrite(PADDING, pp->entry.dataOffset - offset, 1, fd);
+      fwrite(pp->data, pp->entry.dataSize, 1, fd);
+   }
+
+   ReplaceFile(fd, tempPath, cachePath);
+}
+
+#endif /* HAVE_SYS_MMAN_H && HAVE_SYS_STAT_H */
@@ -0,0 +1,60 @@
+/**
+ * @file configcache.h
+ *
+ * @brief Persistent cache of tokenized configuration files.
+ *
+ */
+
+#ifndef CONFIGCACHE_H
+#define CONFIGCACHE_H
+
+struct TokenNode;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+
+struct stat;
+
+/** Open the configuration cache.
+ * This is called before parsing the configuration. Tokens loaded from
+ * the cache are valid until CloseConfigCache is called.
+ */
+void OpenConfigCache(void);
+
+/** Close the configuration cache.
+ * The cache file is rewritten if any configuration file changed.
+ */
+void CloseConfigCache(void);
+
+/** Look up the tokens of a configuration file in the cache.
+ * @param path The expanded path of the configuration file.
+ * @param st The status of the configuration file.
+ * @param fileName The file name to use for error reporting.
+ * @return The tokens (NULL if not cached or out of date).
+ */
+struct TokenNode *LoadCachedConfig(const char *path, const struct stat *st,
+                                   const char *fileName);
+
+/** Add the tokens of a configuration file to the cache.
+ * @param path The expanded path of the configuration file.
+ * @param st The status of the configuration file.
+ * @param tokens The tokens read from the file.
+ */
+void CacheConfig(const char *path, const struct stat *st,
+                 const struct TokenNode *tokens);
+
+/** Remove the cache file so that it is rebuilt on the next start.
+ * This is used for the -clearcache option and does not need X.
+ */
+void ClearConfigCache(void);
+
+#else
+
+#define OpenConfigCache()           (void)(0)
+#define CloseConfigCache()          (void)(0)
+#define LoadCachedConfig( a, b, c ) NULL
+#define CacheConfig( a, b, c )      (void)(0)
+#define ClearConfigCache()          (void)(0)
+
+#endif
+
+#endif /* CONFIGCACHE_H */
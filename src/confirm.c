@@ -17,6 +17,7 @@
 #include "misc.h"
 #include "settings.h"
 #include "binding.h"
+#include "winmap.h"
 
 #ifndef DISABLE_CONFIRM
 
@@ -59,6 +60,7 @@ static void ComputeDimensions(const ClientNode *np);
 static void DrawDialog(void);
 static void DrawButtons(void);
 static void ExposeConfirmDialog(void);
+static char ProcessDialogEvent(void *data, const XEvent *event);
 static char HandleDialogExpose(const XExposeEvent *event); 
 static char HandleDialogButtonPress(const XButtonEvent *event);
 static char HandleDialogButtonRelease(const XButtonEvent *event);
@@ -97,7 +99,7 @@ void RunDialogAction(void)
 }
 
 /** Handle an event on a dialog window. */
-char ProcessDialogEvent(const XEvent *event)
+char ProcessDialogEvent(void *data, const XEvent *event)
 {
 
    Assert(event);
@@ -315,6 +317,10 @@ void ShowConfirmDialog(ClientNode *np, void (*action)(ClientNode*), ...)
    /* Add the client and give it focus. */
    dialog->node = AddClientWindow(window, 0, 0);
    Assert(dialog->node);
+   RegisterWindowHandler(window, OWNER_DIALOG, dialog->node,
+                         ExposureMask | ButtonPressMask
+                         | ButtonReleaseMask | KeyPressMask,
+                         ProcessDialogEvent);
    if(np) {
       dialog->node->owner = np->window;
    }
@@ -505,12 +511,6 @@ void DrawButtons(void)
 
 #else /* DISABLE_CONFIRM */
 
-/** Process an event on a dialog window. */
-char ProcessDialogEvent(const XEvent *event)
-{
-   return 0;
-}
-
 /** Show a confirm dialog. */
 void ShowConfirmDialog(ClientNode *np, void (*action)(ClientNode*), ...)
 {
@@ -19,12 +19,6 @@ void ShutdownDialogs(void);
 #define DestroyDialogs()      (void)(0)
 /*@}*/
 
-/** Handle an event on a dialog window.
- * @param event The event.
- * @return 1 if handled, 0 if not handled.
- */
-char ProcessDialogEvent(const XEvent *event);
-
 /** Show a confirm dialog.
  * @param np A client window associated with the dialog.
  * @param action A callback to run if "OK" is clicked.
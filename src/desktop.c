@@ -155,7 +155,6 @@ void ChangeDesktop(unsigned int desktop)
 {
 
    ClientNode *np;
-   unsigned int x;
 
    if(JUNLIKELY(desktop >= settings.desktopCount)) {
       return;
@@ -168,33 +167,26 @@ void ChangeDesktop(unsigned int desktop)
    /* Hide clients from the old desktop.
     * Note that we show clients in a separate loop to prevent an issue
     * with clients losing focus.
+    * Sticky clients are kept on their own list and are not touched.
+    * The server is grabbed so the switch is drawn in one pass.
     */
-   for(x = 0; x < LAYER_COUNT; x++) {
-      for(np = nodes[x]; np; np = np->next) {
-         if(np->state.status & STAT_STICKY) {
-            continue;
-         }
-         if(np->state.desktop == currentDesktop) {
-            HideClient(np);
-            if((np->state.status & STAT_MINIMIZED) && (np->state.status & STAT_ACTIVE)) {
-               np->state.status &= ~STAT_ACTIVE;
-            }
-         }
+   GrabServer();
+   for(np = GetDesktopClients(currentDesktop); np; np = np->deskNext) {
+      HideClient(np);
+      if((np->state.status & STAT_MINIMIZED) && (np->state.status & STAT_ACTIVE)) {
+         np->state.status &= ~STAT_ACTIVE;
       }
    }
 
    /* Show clients on the new desktop. */
-   for(x = 0; x < LAYER_COUNT; x++) {
-      for(np = nodes[x]; np; np = np->next) {
-         if(np->state.status & STAT_STICKY) {
-            continue;
-         }
-         if(np->state.desktop == desktop) {
-            ShowClient(np);
-         }
-      }
+   for(np = GetDesktopClients(desktop); np; np = np->deskNext) {
+      ShowClient(np);
    }
 
+   /* Send the unmaps and maps together. */
+   UngrabServer();
+   JXFlush(display);
+
    previousDesktop = currentDesktop;
    currentDesktop = desktop;
 
@@ -274,27 +266,23 @@ void ShowDesktop(void)
    int layer;
 
    GrabServer();
-   for(layer = 0; layer < LAYER_COUNT; layer++) {
-      for(np = nodes[layer]; np; np = np->next) {
-         if(np->state.status & STAT_NOLIST) {
-            continue;
+   for(np = GetFirstDesktopClient(currentDesktop); np;
+       np = GetNextDesktopClient(np)) {
+      if(np->state.status & STAT_NOLIST) {
+         continue;
+      }
+      if(showingDesktop[currentDesktop]) {
+         if(np->state.status & STAT_SDESKTOP) {
+            RestoreClient(np, 0);
          }
-         if((np->state.desktop == currentDesktop) ||
-            (np->state.status & STAT_STICKY)) {
-            if(showingDesktop[currentDesktop]) {
-               if(np->state.status & STAT_SDESKTOP) {
-                  RestoreClient(np, 0);
-               }
-            } else {
-               if(np->state.status & STAT_ACTIVE) {
-                  JXSetInputFocus(display, rootWindow, RevertToParent,
-                                  CurrentTime);
-               }
-               if(np->state.status & (STAT_MAPPED | STAT_SHADED) && (np->state.border & BORDER_MIN)) {
-                  MinimizeClient(np, 0);
-                  np->state.status |= STAT_SDESKTOP;
-               }
-            }
+      } else {
+         if(np->state.status & STAT_ACTIVE) {
+            JXSetInputFocus(display, rootWindow, RevertToParent,
+                            CurrentTime);
+         }
+         if(np->state.status & (STAT_MAPPED | STAT_SHADED) && (np->state.border & BORDER_MIN)) {
+            MinimizeClient(np, 0);
+            np->state.status |= STAT_SDESKTOP;
          }
       }
    }
@@ -15,6 +15,8 @@
 #include "color.h"
 #include "misc.h"
 #include "settings.h"
+#include "winmap.h"
+#include "event.h"
 
 #define SYSTEM_TRAY_REQUEST_DOCK    0
 #define SYSTEM_TRAY_BEGIN_MESSAGE   1
@@ -28,6 +30,12 @@ typedef struct DockNode {
 
    Window window;
    char needs_reparent;
+   char needs_configure;   /**< Send a configure event on the next layout. */
+   char placed;            /**< Set once the geometry below is valid. */
+
+   int x, y;               /**< Location in the dock. */
+   int size;               /**< Width and height. */
+   int screenx, screeny;   /**< Location sent in the last configure event. */
 
    struct DockNode *next;
 
@@ -40,6 +48,7 @@ typedef struct DockType {
 
    Window window;
    int itemSize;
+   char resizePending;  /**< Set if windows were added or removed. */
 
    Pixmap buffer;
 
@@ -59,7 +68,7 @@ static void Create(TrayComponentType *cp);
 static void Resize(TrayComponentType *cp);
 
 static void DockWindow(Window win);
-static void UpdateDock(void);
+static void LayoutDock(void);
 static void GetDockItemSize(int *size);
 static void GetDockItemOffset(int *size, int *xoffset, int *yoffset);
 static void GetDockSize(int *width, int *height);
@@ -119,6 +128,7 @@ void ShutdownDock(void)
       /* Release memory used by the dock list. */
       while(dock->nodes) {
          np = dock->nodes->next;
+         UnregisterWindow(dock->nodes->window);
          JXReparentWindow(display, dock->nodes->window, rootWindow, 0, 0);
          Release(dock->nodes);
          dock->nodes = np;
@@ -158,6 +168,7 @@ TrayComponentType *CreateDock(int width)
       dock = Allocate(sizeof(DockType));
       dock->nodes = NULL;
       dock->window = None;
+      dock->resizePending = 0;
    }
 
    cp = CreateTrayComponent();
@@ -280,7 +291,7 @@ void Resize(TrayComponentType *cp)
    tp->buffer = cp->pixmap;
    ClearTrayDrawable(cp);
    JXSetWindowBackgroundPixmap(display, cp->window, tp->buffer);
-   UpdateDock();
+   LayoutDock();
 }
 
 /** Handle a dock event. */
@@ -304,7 +315,7 @@ void HandleDockEvent(const XClientMessageEvent *event)
 /** Handle a resize request event. */
 char HandleDockResizeRequest(const XResizeRequestEvent *event)
 {
-   DockNode *np;
+   void *data;
 
    Assert(event);
 
@@ -312,11 +323,10 @@ char HandleDockResizeRequest(const XResizeRequestEvent *event)
       return 0;
    }
 
-   for(np = dock->nodes; np; np = np->next) {
-      if(np->window == event->window) {
-         UpdateDock();
-         return 1;
-      }
+   if(FindWindowOwner(event->window, &data) == OWNER_DOCK) {
+      ((DockNode*)data)->needs_configure = 1;
+      RequireDockUpdate();
+      return 1;
    }
 
    return 0;
@@ -326,7 +336,7 @@ char HandleDockResizeRequest(const XResizeRequestEvent *event)
 char HandleDockConfigureRequest(const XConfigureRequestEvent *event)
 {
 
-   DockNode *np;
+   void *data;
 
    Assert(event);
 
@@ -334,11 +344,10 @@ char HandleDockConfigureRequest(const XConfigureRequestEvent *event)
       return 0;
    }
 
-   for(np = dock->nodes; np; np = np->next) {
-      if(np->window == event->window) {
-         UpdateDock();
-         return 1;
-      }
+   if(FindWindowOwner(event->window, &data) == OWNER_DOCK) {
+      ((DockNode*)data)->needs_configure = 1;
+      RequireDockUpdate();
+      return 1;
    }
 
    return 0;
@@ -350,7 +359,6 @@ char HandleDockReparentNotify(const XReparentEvent *event)
 {
 
    DockNode *np;
-   char handled;
 
    Assert(event);
 
@@ -359,28 +367,25 @@ char HandleDockReparentNotify(const XReparentEvent *event)
       return 0;
    }
 
-   /* Check each docked window. */
-   handled = 0;
-   for(np = dock->nodes; np; np = np->next) {
-      if(np->window == event->window) {
-         if(event->parent != dock->cp->window) {
-            /* For some reason the application reparented the window.
-             * We make note of this condition and reparent every time
-             * the dock is updated. Unfortunately we can't do this for
-             * all applications because some won't deal with it.
-             */
-            np->needs_reparent = 1;
-            handled = 1;
-         }
-      }
+   /* Check if this is a docked window. */
+   if(FindWindowOwner(event->window, (void**)&np) != OWNER_DOCK) {
+      return 0;
    }
 
-   /* Layout the stuff on the dock again if something happened. */
-   if(handled) {
-      UpdateDock();
+   if(event->parent != dock->cp->window) {
+      /* For some reason the application reparented the window.
+       * We make note of this condition and reparent every time
+       * the dock is updated. Unfortunately we can't do this for
+       * all applications because some won't deal with it.
+       */
+      np->needs_reparent = 1;
+
+      /* Layout the stuff on the dock again. */
+      RequireDockUpdate();
+      return 1;
    }
 
-   return handled;
+   return 0;
 
 }
 
@@ -410,31 +415,30 @@ void DockWindow(Window win)
    }
 
    /* If this window is already docked ignore it. */
-   for(np = dock->nodes; np; np = np->next) {
-      if(np->window == win) {
-         return;
-      }
+   if(FindWindowOwner(win, (void**)&np) == OWNER_DOCK) {
+      return;
    }
 
    /* Add the window to our list. */
    np = Allocate(sizeof(DockNode));
    np->window = win;
    np->needs_reparent = 0;
+   np->needs_configure = 1;
+   np->placed = 0;
    np->next = dock->nodes;
    dock->nodes = np;
+   RegisterWindow(win, OWNER_DOCK, np);
 
-   /* Update the requested size. */
-   GetDockSize(&dock->cp->requestedWidth, &dock->cp->requestedHeight);
-
-   /* It's safe to reparent at (0, 0) since we call
-    * ResizeTray which will invoke the Resize callback.
+   /* It's safe to reparent at (0, 0) since the window is placed
+    * when the dock is updated.
     */
    JXAddToSaveSet(display, win);
    JXReparentWindow(display, win, dock->cp->window, 0, 0);
    JXMapRaised(display, win);
 
    /* Resize the tray containing the dock. */
-   ResizeTray(dock->cp->tray);
+   dock->resizePending = 1;
+   RequireDockUpdate();
 
 }
 
@@ -442,25 +446,30 @@ void DockWindow(Window win)
 char HandleDockDestroy(Window win)
 {
    DockNode **np;
+   void *data;
 
    /* If no dock is running, just return. */
    if(!dock) {
       return 0;
    }
 
+   /* Only walk the list if this is a docked window. */
+   if(FindWindowOwner(win, &data) != OWNER_DOCK) {
+      return 0;
+   }
+
    for(np = &dock->nodes; *np; np = &(*np)->next) {
       DockNode *dp = *np;
       if(dp->window == win) {
 
          /* Remove the window from our list. */
+         UnregisterWindow(win);
          *np = dp->next;
          Release(dp);
 
-         /* Update the requested size. */
-         GetDockSize(&dock->cp->requestedWidth, &dock->cp->requestedHeight);
-
          /* Resize the tray. */
-         ResizeTray(dock->cp->tray);
+         dock->resizePending = 1;
+         RequireDockUpdate();
          return 1;
       }
    }
@@ -468,8 +477,26 @@ char HandleDockDestroy(Window win)
    return 0;
 }
 
-/** Layout items on the dock. */
+/** Update the dock after a batch of events. */
 void UpdateDock(void)
+{
+   if(!dock || dock->cp == NULL || dock->cp->tray == NULL) {
+      return;
+   }
+   if(dock->resizePending) {
+      /* This calls Resize, which lays out the dock. */
+      dock->resizePending = 0;
+      ResizeTrayComponent(dock->cp);
+   } else {
+      LayoutDock();
+   }
+}
+
+/** Place the windows on the dock.
+ * Only windows whose geometry changed are moved and sent a synthetic
+ * configure event.
+ */
+void LayoutDock(void)
 {
 
    XConfigureEvent event;
@@ -491,22 +518,42 @@ void UpdateDock(void)
    memset(&event, 0, sizeof(event));
    for(np = dock->nodes; np; np = np->next) {
 
-      JXMoveResizeWindow(display, np->window, x + xoffset, y + yoffset, itemSize, itemSize);
+      const int screenx = dock->cp->screenx + x;
+      const int screeny = dock->cp->screeny + y;
+      char moved = 0;
+
+      if(!np->placed || np->size != itemSize
+         || np->x != x + xoffset || np->y != y + yoffset) {
+         JXMoveResizeWindow(display, np->window, x + xoffset, y + yoffset,
+                            itemSize, itemSize);
+         np->x = x + xoffset;
+         np->y = y + yoffset;
+         np->size = itemSize;
+         np->placed = 1;
+         moved = 1;
+      }
 
       /* Reparent if this window likes to go other places. */
       if(np->needs_reparent) {
          JXReparentWindow(display, np->window, dock->cp->window, x + xoffset, y + yoffset);
+         moved = 1;
       }
 
-      event.type = ConfigureNotify;
-      event.event = np->window;
-      event.window = np->window;
-      event.x = dock->cp->screenx + x;
-      event.y = dock->cp->screeny + y;
-      event.width = itemSize;
-      event.height = itemSize;
-      JXSendEvent(display, np->window, False, StructureNotifyMask,
-                  (XEvent*)&event);
+      if(moved || np->needs_configure
+         || np->screenx != screenx || np->screeny != screeny) {
+         event.type = ConfigureNotify;
+         event.event = np->window;
+         event.window = np->window;
+         event.x = screenx;
+         event.y = screeny;
+         event.width = itemSize;
+         event.height = itemSize;
+         JXSendEvent(display, np->window, False, StructureNotifyMask,
+                     (XEvent*)&event);
+         np->screenx = screenx;
+         np->screeny = screeny;
+         np->needs_configure = 0;
+      }
 
       if(orientation == SYSTEM_TRAY_ORIENTATION_HORZ) {
          x += itemSize + settings.dockSpacing;
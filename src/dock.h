@@ -60,5 +60,10 @@ char HandleDockConfigureRequest(const XConfigureRequestEvent *event);
  */
 char HandleDockReparentNotify(const XReparentEvent *event);
 
+/** Update the dock after windows were added, removed, or changed.
+ * This is called once per event batch (see RequireDockUpdate).
+ */
+void UpdateDock(void);
+
 #endif
 
@@ -32,6 +32,7 @@
 #include "pager.h"
 #include "grab.h"
 #include "screen.h"
+#include "winmap.h"
 
 #define MIN_TIME_DELTA 50
 
@@ -50,6 +51,17 @@ static CallbackNode *callbacks = NULL;
 static char restack_pending = 0;
 static char task_update_pending = 0;
 static char pager_update_pending = 0;
+static char dock_update_pending = 0;
+
+#ifdef DEBUG
+/** Number of events received and dispatched by owner, by event type. */
+static unsigned long eventCounts[LASTEvent];
+static unsigned long dispatchCounts[LASTEvent];
+
+/** Number of property changes checked and skipped, by digest index. */
+static unsigned long digestChecks[DIGEST_COUNT];
+static unsigned long digestSkips[DIGEST_COUNT];
+#endif
 
 static void Signal(void);
 
@@ -60,6 +72,8 @@ static void HandleConfigureRequest(const XConfigureRequestEvent *event);
 static char HandleConfigureNotify(const XConfigureEvent *event);
 static char HandleExpose(const XExposeEvent *event);
 static char HandlePropertyNotify(const XPropertyEvent *event);
+static char IsPropertyChanged(ClientNode *np, Atom atom,
+                              PropertyDigestIndex index);
 static void HandleClientMessage(const XClientMessageEvent *event);
 static void HandleColormapChange(const XColormapEvent *event);
 static char HandleDestroyNotify(const XDestroyWindowEvent *event);
@@ -84,12 +98,36 @@ static void HandleNetWMState(const XClientMessageEvent *event,
 static void HandleFrameExtentsRequest(const XClientMessageEvent *event);
 static void UpdateState(ClientNode *np);
 static void DiscardEnterEvents();
+static Bool IsNameEvent(Display *d, XEvent *event, XPointer arg);
+static void DiscardNameEvents(Window w);
 static char ClientCanReceiveSloppyFocus(const ClientNode *np);
 
 #ifdef USE_SHAPE
 static void HandleShapeEvent(const XShapeEvent *event);
 #endif
 
+/** Shutdown event processing. */
+void ShutdownEvents(void)
+{
+#ifdef DEBUG
+   int x;
+   for(x = 0; x < LASTEvent; x++) {
+      if(eventCounts[x] > 0) {
+         Debug("event %d: %lu received, %lu dispatched by owner",
+               x, eventCounts[x], dispatchCounts[x]);
+      }
+   }
+   memset(eventCounts, 0, sizeof(eventCounts));
+   memset(dispatchCounts, 0, sizeof(dispatchCounts));
+   for(x = 0; x < DIGEST_COUNT; x++) {
+      Debug("property digest %d: %lu checked, %lu skipped",
+            x, digestChecks[x], digestSkips[x]);
+   }
+   memset(digestChecks, 0, sizeof(digestChecks));
+   memset(digestSkips, 0, sizeof(digestSkips));
+#endif
+}
+
 /** Wait for an event and process it. */
 char WaitForEvent(XEvent *event)
 {
@@ -117,6 +155,13 @@ char WaitForEvent(XEvent *event)
    do {
 
       while(JXPending(display) == 0) {
+         /* Update the dock once the current batch of events is done. */
+         if(dock_update_pending) {
+            dock_update_pending = 0;
+            UpdateDock();
+            Signal();
+            continue;
+         }
          FD_ZERO(&fds);
          FD_SET(fd, &fds);
          timeout.tv_sec = sleepTime / 1000;
@@ -133,6 +178,11 @@ char WaitForEvent(XEvent *event)
 
       JXNextEvent(display, event);
       UpdateTime(event);
+#ifdef DEBUG
+      if(JLIKELY(event->type < LASTEvent)) {
+         eventCounts[event->type] += 1;
+      }
+#endif
 
       switch(event->type) {
       case ConfigureRequest:
@@ -210,6 +260,12 @@ char WaitForEvent(XEvent *event)
          } else if(haveShape && event->type == shapeEvent) {
             HandleShapeEvent((XShapeEvent*)event);
             handled = 1;
+#endif
+#ifdef USE_XCOMPOSITE
+         } else if(haveComposite
+                   && event->type == damageEvent + XDamageNotify) {
+            HandlePagerDamage((XDamageNotifyEvent*)event);
+            handled = 1;
 #endif
          } else {
             handled = 0;
@@ -218,16 +274,12 @@ char WaitForEvent(XEvent *event)
       }
 
       if(!handled) {
-         handled = ProcessTrayEvent(event);
-      }
-      if(!handled) {
-         handled = ProcessDialogEvent(event);
-      }
-      if(!handled) {
-         handled = ProcessSwallowEvent(event);
-      }
-      if(!handled) {
-         handled = ProcessPopupEvent(event);
+         handled = DispatchWindowEvent(event);
+#ifdef DEBUG
+         if(handled && JLIKELY(event->type < LASTEvent)) {
+            dispatchCounts[event->type] += 1;
+         }
+#endif
       }
 
    } while(handled && JLIKELY(!shouldExit));
@@ -241,7 +293,8 @@ void Signal(void)
 {
    static TimeType last = ZERO_TIME;
 
-   CallbackNode *cp;   
+   CallbackNode *cp;
+   CallbackNode *next;
    TimeType now;
    Window w;
    int x, y;
@@ -266,7 +319,9 @@ void Signal(void)
    last = now;
 
    GetMousePosition(&x, &y, &w);
-   for(cp = callbacks; cp; cp = cp->next) {
+   for(cp = callbacks; cp; cp = next) {
+      /* Get the next callback first since this one may unregister. */
+      next = cp->next;
       if(cp->freq == 0 || GetTimeDifference(&now, &cp->last) >= cp->freq) {
          cp->last = now;
          (cp->callback)(&now, x, y, w, cp->data);
@@ -354,6 +409,26 @@ void DiscardEnterEvents()
    }
 }
 
+/** Predicate for name property changes on a window. */
+Bool IsNameEvent(Display *d, XEvent *event, XPointer arg)
+{
+   return event->type == PropertyNotify
+       && event->xproperty.window == *(Window*)arg
+       && (event->xproperty.atom == XA_WM_NAME
+          || event->xproperty.atom == atoms[ATOM_NET_WM_NAME]);
+}
+
+/** Discard queued name changes for a window.
+ * The name is read after this, so only the latest value matters.
+ */
+void DiscardNameEvents(Window w)
+{
+   XEvent event;
+   while(JXCheckIfEvent(display, &event, IsNameEvent, (XPointer)&w)) {
+      UpdateTime(&event);
+   }
+}
+
 /** Process a selection clear event. */
 char HandleSelectionClear(const XSelectionClearEvent *event)
 {
@@ -915,14 +990,9 @@ void HandleConfigureRequest(const XConfigureRequestEvent *event)
          ResetBorder(np);
       } else {
          /* Only the position changed; move the client. */
-         int north, south, east, west;
-         GetBorderSize(&np->state, &north, &south, &east, &west);
-
+         MoveClientFrame(np);
          if(np->parent != None) {
-            JXMoveWindow(display, np->parent, np->x - west, np->y - north);
             SendConfigureEvent(np);
-         } else {
-            JXMoveWindow(display, np->window, np->x, np->y);
          }
       }
 
@@ -1034,6 +1104,23 @@ char HandleExpose(const XExposeEvent *event)
    }
 }
 
+/** Determine if a client property actually changed.
+ * Clients frequently rewrite properties with identical contents; those
+ * updates are dropped here before anything is decoded or redrawn.
+ */
+char IsPropertyChanged(ClientNode *np, Atom atom, PropertyDigestIndex index)
+{
+   const char changed = CheckPropertyDigest(np->window, atom,
+                                            &np->digests[index]);
+#ifdef DEBUG
+   digestChecks[index] += 1;
+   if(!changed) {
+      digestSkips[index] += 1;
+   }
+#endif
+   return changed;
+}
+
 /** Handle a property notify event. */
 char HandlePropertyNotify(const XPropertyEvent *event)
 {
@@ -1042,10 +1129,13 @@ char HandlePropertyNotify(const XPropertyEvent *event)
       char changed = 0;
       switch(event->atom) {
       case XA_WM_NAME:
-         ReadWMName(np);
-         changed = 1;
+         DiscardNameEvents(np->window);
+         UpdateClientName(np);
          break;
       case XA_WM_NORMAL_HINTS:
+         if(!IsPropertyChanged(np, XA_WM_NORMAL_HINTS, DIGEST_NORMAL_HINTS)) {
+            break;
+         }
          ReadWMNormalHints(np);
          if(ConstrainSize(np)) {
             ResetBorder(np);
@@ -1078,21 +1168,31 @@ char HandlePropertyNotify(const XPropertyEvent *event)
          } else if(event->atom == atoms[ATOM_WM_PROTOCOLS]) {
             ReadWMProtocols(np->window, &np->state);
          } else if(event->atom == atoms[ATOM_NET_WM_ICON]) {
+            if(!IsPropertyChanged(np, event->atom, DIGEST_ICON)) {
+               break;
+            }
             LoadIcon(np);
+            InvalidateTaskBarIcon(np);
             changed = 1;
          } else if(event->atom == atoms[ATOM_NET_WM_NAME]) {
-            ReadWMName(np);
-            changed = 1;
+            DiscardNameEvents(np->window);
+            UpdateClientName(np);
          } else if(event->atom == atoms[ATOM_NET_WM_STRUT_PARTIAL]) {
             ReadClientStrut(np);
          } else if(event->atom == atoms[ATOM_NET_WM_STRUT]) {
             ReadClientStrut(np);
          } else if(event->atom == atoms[ATOM_MOTIF_WM_HINTS]) {
+            if(!IsPropertyChanged(np, event->atom, DIGEST_MOTIF_HINTS)) {
+               break;
+            }
             UpdateState(np);
             WriteState(np);
             ResetBorder(np);
             changed = 1;
          } else if(event->atom == atoms[ATOM_NET_WM_WINDOW_OPACITY]) {
+            if(!IsPropertyChanged(np, event->atom, DIGEST_OPACITY)) {
+               break;
+            }
             ReadWMOpacity(np->window, &np->state.opacity);
             if(np->parent != None) {
                SetOpacity(np, np->state.opacity, 1);
@@ -1207,7 +1307,7 @@ void HandleClientMessage(const XClientMessageEvent *event)
       } else if(event->message_type == atoms[ATOM_JWM_EXIT]) {
          Exit(0);
       } else if(event->message_type == atoms[ATOM_JWM_RELOAD]) {
-         ReloadMenu();
+         ReloadConfig();
       } else if(event->message_type == atoms[ATOM_NET_CURRENT_DESKTOP]) {
          ChangeDesktop(event->data.l[0]);
       } else if(event->message_type == atoms[ATOM_NET_SHOWING_DESKTOP]) {
@@ -1665,6 +1765,7 @@ void HandleMapRequest(const XMapEvent *event)
          }
          if(!(np->state.status & STAT_STICKY)) {
             np->state.desktop = currentDesktop;
+            UpdateDesktopList(np);
          }
          if(!(np->state.status & STAT_NOFOCUS)) {
             FocusClient(np);
@@ -1782,6 +1883,7 @@ void UpdateState(ClientNode *np)
       np->next->prev = np;
    }
    nodes[np->state.layer] = np;
+   UpdateDesktopList(np);
 
    if(active) {
       FocusClient(np);
@@ -1878,3 +1980,9 @@ void RequirePagerUpdate()
 {
    pager_update_pending = 1;
 }
+
+/** Update the dock when the event queue is empty. */
+void RequireDockUpdate()
+{
+   dock_update_pending = 1;
+}
@@ -17,6 +17,13 @@ typedef void (*SignalCallback)(const struct TimeType *now,
                                Window w,
                                void *data);
 
+/*@{*/
+#define InitializeEvents() (void)(0)
+#define StartupEvents()    (void)(0)
+void ShutdownEvents(void);
+#define DestroyEvents()    (void)(0)
+/*@}*/
+
 /** Last event time. */
 extern Time eventTime;
 
@@ -51,6 +58,7 @@ void DiscardKeyEvents(XEvent *event, Window w);
 void UpdateTime(const XEvent *event);
 
 /** Register a callback.
+ * A callback may unregister itself when it runs.
  * @param freq The frequency in milliseconds.
  * @param callback The callback function.
  * @param data Data to pass to the callback.
@@ -72,5 +80,8 @@ void RequireTaskUpdate();
 /** Update the pager before waiting for an event. */
 void RequirePagerUpdate();
 
+/** Update the dock when the event queue is empty. */
+void RequireDockUpdate();
+
 #endif /* EVENT_H */
 
@@ -25,9 +25,13 @@ typedef unsigned int MatchType;
 #define MATCH_MACHINE   3  /**< Match the window client machine name. */
 #define MATCH_TITLE     4  /**< Match the window title. */
 
+/** Number of buckets in the class and name indexes. */
+#define GROUP_INDEX_SIZE   64
+
 /** List of match patterns for a group. */
 typedef struct PatternListType {
-   char *pattern;
+   PatternType pattern;
+   int windowType;      /**< Window type for MATCH_TYPE. */
    MatchType match;
    struct PatternListType *next;
 } PatternListType;
@@ -48,16 +52,143 @@ typedef struct OptionListType {
 typedef struct GroupType {
    PatternListType *patterns;
    OptionListType *options;
+   unsigned int index;     /**< Creation order. */
    struct GroupType *next;
 } GroupType;
 
+/** Index entry mapping an exact class or name to a group. */
+typedef struct GroupIndexNode {
+   const char *key;
+   GroupType *group;
+   struct GroupIndexNode *next;
+} GroupIndexNode;
+
+static const StringMappingType windowTypeMapping[] = {
+   { "desktop",      WINDOW_TYPE_DESKTOP      },
+   { "dialog",       WINDOW_TYPE_DIALOG       },
+   { "dock",         WINDOW_TYPE_DOCK         },
+   { "menu",         WINDOW_TYPE_MENU         },
+   { "normal",       WINDOW_TYPE_NORMAL       },
+   { "notification", WINDOW_TYPE_NOTIFICATION },
+   { "splash",       WINDOW_TYPE_SPLASH       },
+   { "toolbar",      WINDOW_TYPE_TOOLBAR      },
+   { "utility",      WINDOW_TYPE_UTILITY      }
+};
+
 static GroupType *groups = NULL;
+static unsigned int groupCount = 0;
+
+/* Groups whose class (or, failing that, name) patterns are all exact
+ * strings are indexed by those strings. All other groups are kept on
+ * a separate list and are always checked. */
+static GroupIndexNode *classIndex[GROUP_INDEX_SIZE];
+static GroupIndexNode *nameIndex[GROUP_INDEX_SIZE];
+static GroupIndexNode *otherGroups = NULL;
 
 static void ReleasePatternList(PatternListType *lp);
 static void ReleaseOptionList(OptionListType *lp);
 static void AddPattern(PatternListType **lp, const char *pattern,
                        MatchType match);
 static void ApplyGroup(const GroupType *gp, ClientNode *np);
+static char MatchGroup(const GroupType *gp, const ClientNode *np);
+static char IsExactGroup(const GroupType *gp, MatchType match);
+static void AddGroupIndex(GroupIndexNode **index, GroupType *gp,
+                          MatchType match);
+static void ReleaseGroupIndex(GroupIndexNode **np);
+static unsigned int FindGroupCandidates(GroupIndexNode **index,
+                                        const char *key,
+                                        const GroupType **candidates,
+                                        unsigned int count);
+static int GroupComparator(const void *a, const void *b);
+
+/** Build the group index. */
+void StartupGroups(void)
+{
+   GroupIndexNode **tail = &otherGroups;
+   GroupType *gp;
+
+   memset(classIndex, 0, sizeof(classIndex));
+   memset(nameIndex, 0, sizeof(nameIndex));
+   for(gp = groups; gp; gp = gp->next) {
+      if(IsExactGroup(gp, MATCH_CLASS)) {
+         AddGroupIndex(classIndex, gp, MATCH_CLASS);
+      } else if(IsExactGroup(gp, MATCH_NAME)) {
+         AddGroupIndex(nameIndex, gp, MATCH_NAME);
+      } else {
+         *tail = Allocate(sizeof(GroupIndexNode));
+         (*tail)->key = NULL;
+         (*tail)->group = gp;
+         (*tail)->next = NULL;
+         tail = &(*tail)->next;
+      }
+   }
+}
+
+/** Release the group index. */
+void ShutdownGroups(void)
+{
+   unsigned int x;
+   for(x = 0; x < GROUP_INDEX_SIZE; x++) {
+      ReleaseGroupIndex(&classIndex[x]);
+      ReleaseGroupIndex(&nameIndex[x]);
+   }
+   ReleaseGroupIndex(&otherGroups);
+}
+
+/** Release a list of index nodes. */
+void ReleaseGroupIndex(GroupIndexNode **np)
+{
+   while(*np) {
+      GroupIndexNode *next = (*np)->next;
+      Release(*np);
+      *np = next;
+   }
+}
+
+/** Determine if all patterns of a kind in a group are exact strings.
+ * Returns 0 if the group has no patterns of the kind.
+ */
+char IsExactGroup(const GroupType *gp, MatchType match)
+{
+   const PatternListType *lp;
+   char found = 0;
+   for(lp = gp->patterns; lp; lp = lp->next) {
+      if(lp->match == match) {
+         if(lp->pattern.kind != PATTERN_EXACT) {
+            return 0;
+         }
+         found = 1;
+      }
+   }
+   return found;
+}
+
+/** Add a group to an index under each of its exact strings. */
+void AddGroupIndex(GroupIndexNode **index, GroupType *gp, MatchType match)
+{
+   const PatternListType *lp;
+   for(lp = gp->patterns; lp; lp = lp->next) {
+      if(lp->match == match) {
+         const char *key = lp->pattern.text;
+         const unsigned int bucket = HashString(key) % GROUP_INDEX_SIZE;
+         GroupIndexNode *np;
+
+         /* Skip duplicate strings in the same group. */
+         for(np = index[bucket]; np; np = np->next) {
+            if(np->group == gp && !strcmp(np->key, key)) {
+               break;
+            }
+         }
+         if(np == NULL) {
+            np = Allocate(sizeof(GroupIndexNode));
+            np->key = key;
+            np->group = gp;
+            np->next = index[bucket];
+            index[bucket] = np;
+         }
+      }
+   }
+}
 
 /** Destroy group data. */
 void DestroyGroups(void)
@@ -70,6 +201,7 @@ void DestroyGroups(void)
       Release(groups);
       groups = gp;
    }
+   groupCount = 0;
 }
 
 /** Release a group pattern list. */
@@ -78,7 +210,7 @@ void ReleasePatternList(PatternListType *lp)
    PatternListType *tp;
    while(lp) {
       tp = lp->next;
-      Release(lp->pattern);
+      ReleasePattern(&lp->pattern);
       Release(lp);
       lp = tp;
    }
@@ -105,8 +237,10 @@ GroupType *CreateGroup(void)
    tp = Allocate(sizeof(GroupType));
    tp->patterns = NULL;
    tp->options = NULL;
+   tp->index = groupCount;
    tp->next = groups;
    groups = tp;
+   groupCount += 1;
    return tp;
 }
 
@@ -174,8 +308,15 @@ void AddPattern(PatternListType **lp, const char *pattern, MatchType match)
    tp = Allocate(sizeof(PatternListType));
    tp->next = *lp;
    *lp = tp;
-   tp->pattern = CopyString(pattern);
+   if(JUNLIKELY(!CompilePattern(&tp->pattern, pattern))) {
+      Warning(_("invalid group pattern: %s"), pattern);
+   }
    tp->match = match;
+   tp->windowType = -1;
+   if(match == MATCH_TYPE) {
+      tp->windowType = FindValue(windowTypeMapping, WINDOW_TYPE_COUNT,
+                                 pattern);
+   }
 }
 
 /** Add an option to a group. */
@@ -244,86 +385,120 @@ void AddGroupOptionDouble(GroupType *gp, OptionType option,
    gp->options = lp;
 }
 
+/** Collect the groups indexed under a key. */
+unsigned int FindGroupCandidates(GroupIndexNode **index, const char *key,
+                                 const GroupType **candidates,
+                                 unsigned int count)
+{
+   const GroupIndexNode *ip;
+   if(key) {
+      ip = index[HashString(key) % GROUP_INDEX_SIZE];
+      for(; ip; ip = ip->next) {
+         if(!strcmp(ip->key, key)) {
+            candidates[count] = ip->group;
+            count += 1;
+         }
+      }
+   }
+   return count;
+}
+
+/** Comparator to order groups with the most recent first. */
+int GroupComparator(const void *a, const void *b)
+{
+   const GroupType *ga = *(const GroupType**)a;
+   const GroupType *gb = *(const GroupType**)b;
+   return ga->index < gb->index ? 1 : -1;
+}
+
 /** Apply groups to a client. */
 void ApplyGroups(ClientNode *np)
 {
-   PatternListType *lp;
-   GroupType *gp;
-   char hasClass;
-   char hasName;
-   char hasTitle;
-   char hasType;
-   char hasClient;
-   char matchesClass;
-   char matchesName;
-   char matchesTitle;
-   char matchesType;
-   char matchesClient;
-
-   static const StringMappingType windowTypeMapping[] = {
-      { "desktop",      WINDOW_TYPE_DESKTOP      },
-      { "dialog",       WINDOW_TYPE_DIALOG       },
-      { "dock",         WINDOW_TYPE_DOCK         },
-      { "menu",         WINDOW_TYPE_MENU         },
-      { "normal",       WINDOW_TYPE_NORMAL       },
-      { "notification", WINDOW_TYPE_NOTIFICATION },
-      { "splash",       WINDOW_TYPE_SPLASH       },
-      { "toolbar",      WINDOW_TYPE_TOOLBAR      },
-      { "utility",      WINDOW_TYPE_UTILITY      }
-   };
+   const GroupType **candidates;
+   const GroupIndexNode *ip;
+   unsigned int count;
+   unsigned int x;
 
    Assert(np);
-   for(gp = groups; gp; gp = gp->next) {
-      hasClass = 0;
-      hasName = 0;
-      hasType = 0;
-      hasTitle = 0;
-      hasClient = 0;
-      matchesClass = 0;
-      matchesName = 0;
-      matchesTitle = 0;
-      matchesType = 0;
-      matchesClient = 0;
-      for(lp = gp->patterns; lp; lp = lp->next) {
-         if(lp->match == MATCH_CLASS) {
-            if(Match(lp->pattern, np->className)) {
-               matchesClass = 1;
-            }
-            hasClass = 1;
-         } else if(lp->match == MATCH_NAME) {
-            if(Match(lp->pattern, np->instanceName)) {
-               matchesName = 1;
-            }
-            hasName = 1;
-         } else if(lp->match == MATCH_TITLE) {
-            if(Match(lp->pattern, np->name)) {
-               matchesTitle = 1;
-            }
-            hasTitle = 1;
-         } else if(lp->match == MATCH_TYPE) {
-             if(FindValue(windowTypeMapping, WINDOW_TYPE_COUNT, lp->pattern)
-             == np->state.windowType) {
-                matchesType = 1;
-             }
-             hasType = 1;
-         } else if(lp->match == MATCH_MACHINE) {
-            if(Match(lp->pattern, np->clientName)) {
-               matchesClient = 1;
-            }
-             hasClient = 1;
-         } else {
-            Debug("invalid match in ApplyGroups: %d", lp->match);
-         }
-      }
-      if(hasName == matchesName
-      && hasClass == matchesClass
-      && hasTitle == matchesTitle
-      && hasType == matchesType
-      && hasClient == matchesClient) {
-         ApplyGroup(gp, np);
+
+   if(groupCount == 0) {
+      return;
+   }
+
+   /* Only groups that can match are considered.
+    * A group is on at most one of these lists and the class and name
+    * each match at most one key, so there are at most groupCount. */
+   candidates = AllocateStack(sizeof(GroupType*) * groupCount);
+   count = FindGroupCandidates(classIndex, np->className, candidates, 0);
+   count = FindGroupCandidates(nameIndex, np->instanceName,
+                               candidates, count);
+   for(ip = otherGroups; ip; ip = ip->next) {
+      candidates[count] = ip->group;
+      count += 1;
+   }
+   Assert(count <= groupCount);
+
+   /* Apply groups in the same order as the group list. */
+   qsort(candidates, count, sizeof(GroupType*), GroupComparator);
+   for(x = 0; x < count; x++) {
+      if(MatchGroup(candidates[x], np)) {
+         ApplyGroup(candidates[x], np);
       }
    }
+   ReleaseStack(candidates);
+
+}
 
+/** Determine if a client matches all pattern kinds in a group. */
+char MatchGroup(const GroupType *gp, const ClientNode *np)
+{
+   const PatternListType *lp;
+   char hasClass = 0;
+   char hasName = 0;
+   char hasTitle = 0;
+   char hasType = 0;
+   char hasClient = 0;
+   char matchesClass = 0;
+   char matchesName = 0;
+   char matchesTitle = 0;
+   char matchesType = 0;
+   char matchesClient = 0;
+
+   for(lp = gp->patterns; lp; lp = lp->next) {
+      if(lp->match == MATCH_CLASS) {
+         if(!matchesClass && MatchPattern(&lp->pattern, np->className)) {
+            matchesClass = 1;
+         }
+         hasClass = 1;
+      } else if(lp->match == MATCH_NAME) {
+         if(!matchesName && MatchPattern(&lp->pattern, np->instanceName)) {
+            matchesName = 1;
+         }
+         hasName = 1;
+      } else if(lp->match == MATCH_TITLE) {
+         if(!matchesTitle && MatchPattern(&lp->pattern, np->name)) {
+            matchesTitle = 1;
+         }
+         hasTitle = 1;
+      } else if(lp->match == MATCH_TYPE) {
+         if(lp->windowType == np->state.windowType) {
+            matchesType = 1;
+         }
+         hasType = 1;
+      } else if(lp->match == MATCH_MACHINE) {
+         if(!matchesClient && MatchPattern(&lp->pattern, np->clientName)) {
+            matchesClient = 1;
+         }
+         hasClient = 1;
+      } else {
+         Debug("invalid match in ApplyGroups: %d", lp->match);
+      }
+   }
+   return hasName == matchesName
+       && hasClass == matchesClass
+       && hasTitle == matchesTitle
+       && hasType == matchesType
+       && hasClient == matchesClient;
 }
 
 /** Apply a group to a client. */
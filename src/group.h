@@ -66,8 +66,8 @@ typedef unsigned char OptionType;
 
 /*@{*/
 #define InitializeGroups() (void)(0)
-#define StartupGroups()    (void)(0)
-#define ShutdownGroups()   (void)(0)
+void StartupGroups(void);
+void ShutdownGroups(void);
 void DestroyGroups(void);
 /*@}*/
 
@@ -180,6 +180,8 @@ static char CheckShape(Window win);
 static void WriteNetAllowed(ClientNode *np);
 static void ReadWMState(Window win, ClientState *state);
 static void ReadMotifHints(Window win, ClientState *state);
+static char HashProperty(Window win, Atom atom,
+                         unsigned long *size, unsigned int *hash);
 
 /** Set root hints and intern atoms. */
 void StartupHints(void)
@@ -331,7 +333,11 @@ void WriteState(ClientNode *np)
 {
    unsigned long data[2];
 
-   if(np->state.status & STAT_MAPPED) {
+   if((np->state.status & STAT_HIDDEN)
+      && (np->state.status & STAT_MAPPED)
+      && settings.desktopHide == DHIDE_ICONIC) {
+      data[0] = IconicState;
+   } else if(np->state.status & STAT_MAPPED) {
       data[0] = NormalState;
    } else if(np->state.status & STAT_MINIMIZED) {
       data[0] = IconicState;
@@ -788,6 +794,8 @@ void ReadWMName(ClientNode *np)
       }
    }
 
+   np->nameHash = np->name ? HashString(np->name) : 0;
+
 }
 
 /** Read the machine name of a client. */
@@ -1040,6 +1048,87 @@ void ReadWMHints(Window win, ClientState *state, char alreadyMapped)
 
 }
 
+/** Determine if a property has changed since it was last checked. */
+char CheckPropertyDigest(Window win, Atom atom, PropertyDigest *digest)
+{
+   unsigned long size;
+   unsigned int hash;
+
+   if(JUNLIKELY(!HashProperty(win, atom, &size, &hash))) {
+      digest->valid = 0;
+      return 1;
+   }
+
+   if(digest->valid && digest->size == size && digest->hash == hash) {
+      return 0;
+   }
+   digest->size = size;
+   digest->hash = hash;
+   digest->valid = 1;
+   return 1;
+}
+
+/** Hash the contents of a property.
+ * @param win The window.
+ * @param atom The property.
+ * @param size Set to the size of the property in bytes.
+ * @param hash Set to the hash of the property.
+ * @return 1 on success, 0 on failure.
+ */
+char HashProperty(Window win, Atom atom,
+                  unsigned long *size, unsigned int *hash)
+{
+   unsigned long count;
+   unsigned long extra;
+   unsigned long bytes;
+   unsigned char *data;
+   Atom realType;
+   int realFormat;
+   int status;
+
+   status = JXGetWindowProperty(display, win, atom, 0, LONG_MAX, False,
+                                AnyPropertyType, &realType, &realFormat,
+                                &count, &extra, &data);
+   if(JUNLIKELY(status != Success)) {
+      return 0;
+   }
+
+   /* Xlib returns 32-bit items as longs and 16-bit items as shorts. */
+   switch(realFormat) {
+   case 32:
+      bytes = count * sizeof(long);
+      *size = count * 4;
+      break;
+   case 16:
+      bytes = count * sizeof(short);
+      *size = count * 2;
+      break;
+   default:
+      bytes = count;
+      *size = count;
+      break;
+   }
+   *hash = (unsigned int)realType * 31 + (unsigned int)*size;
+   if(data) {
+      *hash = *hash * 31 + HashData(data, bytes);
+      JXFree(data);
+   }
+   return 1;
+}
+
+/** Compute the digests of client properties. */
+void ReadPropertyDigests(Window win, PropertyDigest *digests)
+{
+   CheckPropertyDigest(win, atoms[ATOM_NET_WM_ICON],
+                       &digests[DIGEST_ICON]);
+   CheckPropertyDigest(win, atoms[ATOM_MOTIF_WM_HINTS],
+                       &digests[DIGEST_MOTIF_HINTS]);
+   CheckPropertyDigest(win, XA_WM_NORMAL_HINTS,
+                       &digests[DIGEST_NORMAL_HINTS]);
+   CheckPropertyDigest(win, atoms[ATOM_NET_WM_WINDOW_OPACITY],
+                       &digests[DIGEST_OPACITY]);
+}
+
 /** Read _NET_WM_WINDOW_OPACITY. */
 void ReadWMOpacity(Window win, unsigned *opacity)
 {
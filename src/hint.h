@@ -170,6 +170,21 @@ typedef struct ClientState {
    unsigned char windowType;     /**< Window type. */
 } ClientState;  /* !! Keep in sync: defaults go in ReadWindowState() */
 
+/** Enumeration of client properties with cached digests. */
+typedef unsigned char PropertyDigestIndex;
+#define DIGEST_ICON           0  /**< _NET_WM_ICON */
+#define DIGEST_MOTIF_HINTS    1  /**< _MOTIF_WM_HINTS */
+#define DIGEST_NORMAL_HINTS   2  /**< WM_NORMAL_HINTS */
+#define DIGEST_OPACITY        3  /**< _NET_WM_WINDOW_OPACITY */
+#define DIGEST_COUNT          4
+
+/** Digest of the raw contents of a property. */
+typedef struct PropertyDigest {
+   unsigned long size;  /**< Size of the property in bytes. */
+   unsigned int hash;   /**< Hash of the property contents. */
+   char valid;          /**< Set if the digest has been computed. */
+} PropertyDigest;
+
 extern Atom atoms[ATOM_COUNT];
 
 /*@{*/
@@ -238,6 +253,24 @@ ClientState ReadWindowState(Window win, char alreadyMapped);
  */
 void ReadWMHints(Window win, ClientState *state, char alreadyMapped);
 
+/** Determine if a property has changed since it was last checked.
+ * The digest covers the type, size, and full contents of the property.
+ * The digest is updated.
+ * @param win The window.
+ * @param atom The property.
+ * @param digest The digest from the last check.
+ * @return 1 if the property changed (or was not checked before), 0 if not.
+ */
+char CheckPropertyDigest(Window win, Atom atom, PropertyDigest *digest);
+
+/** Compute the digests of client properties.
+ * This is called before the properties are read when a client is added
+ * so that later changes are compared against what was read.
+ * @param win The client window.
+ * @param digests The digests to set (DIGEST_COUNT entries).
+ */
+void ReadPropertyDigests(Window win, PropertyDigest *digests);
+
 /** Read opacity.
  * @param win The window.
  * @param opacity The opacity to update.
@@ -18,6 +18,9 @@
 #include "color.h"
 #include "settings.h"
 #include "border.h"
+#include "menu.h"
+
+#include <fcntl.h>
 
 IconNode emptyIcon;
 
@@ -26,9 +29,33 @@ IconNode emptyIcon;
 /* Must be a power of two. */
 #define HASH_SIZE 128
 
+/* Size of the shared icon table (must be a power of two). */
+#define CONTENT_HASH_SIZE 64
+
+/* Size of the scaled icon cache table (must be a power of two). */
+#define SCALED_HASH_SIZE 256
+
+/* Server memory to allow for scaled icons before evicting (bytes). */
+#define SCALED_ICON_BUDGET (8 << 20)
+
+#if defined(HAVE_DIRENT_H) && defined(HAVE_SYS_INOTIFY_H)
+#  define USE_ICON_INDEX
+#endif
+
+/* Number of buckets for icon directory indexes (must be a power of two). */
+#define NAME_HASH_SIZE 256
+
+/** A file name in an icon directory index or the negative cache. */
+typedef struct IconNameNode {
+   struct IconNameNode *next;
+   char name[1];
+} IconNameNode;
+
 /** Linked list of icon paths. */
 typedef struct IconPathNode {
    char *path;
+   IconNameNode **names;   /**< Files in the directory (NULL if unknown). */
+   int watch;              /**< inotify watch (-1 if not watched). */
    struct IconPathNode *next;
 } IconPathNode;
 
@@ -62,22 +89,96 @@ static const unsigned EXTENSION_COUNT = ARRAY_LENGTH(ICON_EXTENSIONS);
 static const unsigned MAX_EXTENSION_LENGTH = 5;
 
 static IconNode **iconHash;
+static IconNode **contentHash;
+
+/** Scaled icon cache, shared by all icons.
+ * Nodes are found by (icon, width, height, fg) in scaledHash and are
+ * evicted in least-recently-used order once the budget is exceeded.
+ */
+static ScaledIconNode **scaledHash;
+static ScaledIconNode *scaledHead;
+static ScaledIconNode *scaledTail;
+static unsigned long scaledBytes;
 static IconPathNode *iconPaths;
 static IconPathNode *iconPathsTail;
 static GC iconGC;
 static char iconSizeSet = 0;
 static char *defaultIconName;
 
+#ifdef USE_ICON_INDEX
+/** Icon directories are indexed by name and kept up to date via inotify.
+ * Names that could not be found in any directory are remembered in
+ * missingNames until a directory changes.
+ */
+static int iconNotify = -1;
+static IconNameNode **missingNames;
+#endif
+
+/** Maximum number of images considered in a _NET_WM_ICON property. */
+#define MAX_NET_ICONS 32
+
+/** Maximum number of distinct icon sizes tracked. */
+#define MAX_ICON_SIZES 8
+
+/** Icon sizes that are actually drawn (see RequestIconSize). */
+static int iconSizes[MAX_ICON_SIZES];
+static unsigned int iconSizeCount;
+
+#ifdef DEBUG
+/** Client icon sharing statistics. */
+static unsigned long sharedIconLoads;
+static unsigned long sharedIconHits;
+static unsigned long sharedBytesSaved;
+
+/** Scaled icon cache statistics. */
+static unsigned long scaledHits;
+static unsigned long scaledMisses;
+static unsigned long scaledEvictions;
+static unsigned long scaledPeakBytes;
+#endif
+
 static void DoDestroyIcon(int index, IconNode *icon);
+static void FreeIcon(IconNode *icon);
+static void UnlinkIcon(IconNode **table, unsigned int index, IconNode *icon);
+static IconNode *ShareIcon(IconNode *icon);
+static char IsSameIcon(const IconNode *a, const IconNode *b);
+static unsigned int GetImageSize(const ImageNode *image);
+
+static unsigned int GetScaledHash(const IconNode *icon, long fg,
+                                  int width, int height);
+static ScaledIconNode *FindScaledIcon(IconNode *icon, long fg,
+                                      int width, int height);
+static void InsertScaledIcon(IconNode *icon, ScaledIconNode *np, long fg,
+                             int width, int height);
+static void ReleaseScaledIcon(ScaledIconNode *np);
 static IconNode *ReadNetWMIcon(Window win);
 static IconNode *ReadWMHintIcon(Window win);
 static IconNode *CreateIcon(const ImageNode *image);
 static IconNode *CreateIconFromDrawable(Drawable d, Pixmap mask);
-static IconNode *CreateIconFromBinary(const unsigned long *data,
-                                      unsigned int length);
-static IconNode *LoadNamedIconHelper(const char *name, const char *path,
+static char ReadNetWMIconData(Window win, long offset, unsigned long count,
+                              unsigned long **data);
+static void SelectNetWMIcons(const unsigned long *widths,
+                             const unsigned long *heights,
+                             unsigned int count, char *selected);
+static IconNode *LoadNamedIconHelper(const char *name,
+                                     const IconPathNode *ip,
                                      char save, char preserveAspect);
 
+#ifdef USE_ICON_INDEX
+static void StartupIconIndex(void);
+static void ShutdownIconIndex(void);
+static void ProcessIconNotify(void);
+static void IndexIconPath(IconPathNode *ip);
+static IconNameNode **CreateNameTable(void);
+static void DestroyNameTable(IconNameNode **table);
+static void AddName(IconNameNode **table, const char *name);
+static char HasName(IconNameNode **table, const char *name);
+#else
+#define StartupIconIndex()    (void)(0)
+#define ShutdownIconIndex()   (void)(0)
+#define ProcessIconNotify()   (void)(0)
+#endif
+
 static ImageNode *GetBestImage(IconNode *icon, int rwidth, int rheight);
 static ScaledIconNode *GetScaledIcon(IconNode *icon, long fg,
                                      int rwidth, int rheight);
@@ -98,8 +199,20 @@ void InitializeIcons(void)
    for(x = 0; x < HASH_SIZE; x++) {
       iconHash[x] = NULL;
    }
+   contentHash = Allocate(sizeof(IconNode*) * CONTENT_HASH_SIZE);
+   for(x = 0; x < CONTENT_HASH_SIZE; x++) {
+      contentHash[x] = NULL;
+   }
+   scaledHash = Allocate(sizeof(ScaledIconNode*) * SCALED_HASH_SIZE);
+   for(x = 0; x < SCALED_HASH_SIZE; x++) {
+      scaledHash[x] = NULL;
+   }
+   scaledHead = NULL;
+   scaledTail = NULL;
+   scaledBytes = 0;
    memset(&emptyIcon, 0, sizeof(emptyIcon));
    iconSizeSet = 0;
+   iconSizeCount = 0;
    defaultIconName = NULL;
 }
 
@@ -120,17 +233,46 @@ void StartupIcons(void)
    iconSize.width_inc = 1;
    iconSize.height_inc = 1;
    JXSetIconSizes(display, rootWindow, &iconSize, 1);
+   RequestIconSize(iconSize.min_width);
+
+   /* Window list menus show client icons; menus are only initialized
+    * after existing clients have loaded their icons. */
+   RequestIconSize(GetMenuIconSize());
+
+   StartupIconIndex();
 }
 
 /** Shutdown icon support. */
 void ShutdownIcons(void)
 {
    unsigned int x;
+   ShutdownIconIndex();
    for(x = 0; x < HASH_SIZE; x++) {
       while(iconHash[x]) {
          DoDestroyIcon(x, iconHash[x]);
       }
    }
+   for(x = 0; x < CONTENT_HASH_SIZE; x++) {
+      while(contentHash[x]) {
+         IconNode *icon = contentHash[x];
+         UnlinkIcon(contentHash, x, icon);
+         FreeIcon(icon);
+      }
+   }
+#ifdef DEBUG
+   Debug("client icons: %lu loaded, %lu shared, %lu bytes saved",
+         sharedIconLoads, sharedIconHits, sharedBytesSaved);
+   sharedIconLoads = 0;
+   sharedIconHits = 0;
+   sharedBytesSaved = 0;
+   Debug("scaled icons: %lu hits, %lu misses, %lu evicted, "
+         "%lu bytes peak (budget %lu)", scaledHits, scaledMisses,
+         scaledEvictions, scaledPeakBytes, (unsigned long)SCALED_ICON_BUDGET);
+   scaledHits = 0;
+   scaledMisses = 0;
+   scaledEvictions = 0;
+   scaledPeakBytes = 0;
+#endif
    JXFreeGC(display, iconGC);
 }
 
@@ -149,6 +291,14 @@ void DestroyIcons(void)
       Release(iconHash);
       iconHash = NULL;
    }
+   if(contentHash) {
+      Release(contentHash);
+      contentHash = NULL;
+   }
+   if(scaledHash) {
+      Release(scaledHash);
+      scaledHash = NULL;
+   }
    if(defaultIconName) {
       Release(defaultIconName);
       defaultIconName = NULL;
@@ -156,34 +306,30 @@ void DestroyIcons(void)
 }
 
 /** Add an icon search path. */
-void AddIconPath(char *path)
+void AddIconPath(const char *path)
 {
 
    IconPathNode *ip;
    int length;
-   char addSep;
 
    if(!path) {
       return;
    }
 
-   Trim(path);
-
-   length = strlen(path);
-   if(path[length - 1] != '/') {
-      addSep = 1;
-   } else {
-      addSep = 0;
-   }
-
+   /* Trim a copy; the path may be shared with other tokens. */
    ip = Allocate(sizeof(IconPathNode));
-   ip->path = Allocate(length + addSep + 1);
-   memcpy(ip->path, path, length + 1);
-   if(addSep) {
+   ip->path = Allocate(strlen(path) + 2);
+   strcpy(ip->path, path);
+   Trim(ip->path);
+
+   length = strlen(ip->path);
+   if(length == 0 || ip->path[length - 1] != '/') {
       ip->path[length] = '/';
       ip->path[length + 1] = 0;
    }
    ExpandPath(&ip->path);
+   ip->names = NULL;
+   ip->watch = -1;
    ip->next = NULL;
 
    if(iconPathsTail) {
@@ -325,28 +471,72 @@ IconNode *LoadNamedIcon(const char *name, char save, char preserveAspect)
    }
 
    /* Try icon paths. */
+   ProcessIconNotify();
+#ifdef USE_ICON_INDEX
+   if(missingNames && HasName(missingNames, name)) {
+      return NULL;
+   }
+#endif
    for(ip = iconPaths; ip; ip = ip->next) {
-      icon = LoadNamedIconHelper(name, ip->path, save, preserveAspect);
+      icon = LoadNamedIconHelper(name, ip, save, preserveAspect);
       if(icon) {
          return icon;
       }
    }
 
+#ifdef USE_ICON_INDEX
+   /* Remember the miss if all paths are being watched. */
+   if(missingNames && !strchr(name, '/')) {
+      for(ip = iconPaths; ip; ip = ip->next) {
+         if(ip->watch < 0) {
+            break;
+         }
+      }
+      if(!ip) {
+         AddName(missingNames, name);
+      }
+   }
+#endif
+
    /* The default icon. */
    return NULL;
 }
 
 /** Helper for loading icons by name. */
-IconNode *LoadNamedIconHelper(const char *name, const char *path,
+IconNode *LoadNamedIconHelper(const char *name, const IconPathNode *ip,
                               char save, char preserveAspect)
 {
    ImageNode *image;
    char *temp;
+   const char *path = ip->path;
    const unsigned nameLength = strlen(name);
    const unsigned pathLength = strlen(path);
    const char hasExtension = strchr(name, '.') != NULL;
    unsigned i;
 
+#ifdef USE_ICON_INDEX
+   /* Check the directory index instead of the file system.
+    * Names with a directory component are not indexed. */
+   if(ip->names && !strchr(name, '/')) {
+      temp = AllocateStack(nameLength + MAX_EXTENSION_LENGTH + 1);
+      memcpy(temp, name, nameLength + 1);
+      if(!hasExtension || !HasName(ip->names, temp)) {
+         for(i = 0; i < EXTENSION_COUNT; i++) {
+            const unsigned len = strlen(ICON_EXTENSIONS[i]);
+            memcpy(&temp[nameLength], ICON_EXTENSIONS[i], len + 1);
+            if(HasName(ip->names, temp)) {
+               break;
+            }
+         }
+         if(i == EXTENSION_COUNT) {
+            ReleaseStack(temp);
+            return NULL;
+         }
+      }
+      ReleaseStack(temp);
+   }
+#endif
+
    /* Full file name. */
    temp = AllocateStack(nameLength + pathLength + MAX_EXTENSION_LENGTH + 1);
    memcpy(&temp[0], path, pathLength);
@@ -384,25 +574,187 @@ IconNode *LoadNamedIconHelper(const char *name, const char *path,
    return NULL;
 }
 
-/** Read the icon property from a client. */
-IconNode *ReadNetWMIcon(Window win)
+/** Register a size at which icons are drawn. */
+void RequestIconSize(int size)
 {
-   static const long MAX_LENGTH = 1 << 20;
-   IconNode *icon = NULL;
-   unsigned long count;
-   int status;
+   unsigned int x;
+   if(size <= 0) {
+      return;
+   }
+   for(x = 0; x < iconSizeCount; x++) {
+      if(iconSizes[x] == size) {
+         return;
+      }
+   }
+   if(iconSizeCount < MAX_ICON_SIZES) {
+      iconSizes[iconSizeCount] = size;
+      iconSizeCount += 1;
+   } else {
+      /* Table full; replace the nearest smaller size so the largest
+       * requested size is never lost. */
+      unsigned int best = MAX_ICON_SIZES;
+      for(x = 0; x < iconSizeCount; x++) {
+         if(iconSizes[x] < size
+            && (best == MAX_ICON_SIZES || iconSizes[x] > iconSizes[best])) {
+            best = x;
+         }
+      }
+      if(best < MAX_ICON_SIZES) {
+         iconSizes[best] = size;
+      }
+   }
+}
+
+/** Read part of the _NET_WM_ICON property.
+ * @param win The window.
+ * @param offset The offset in 32-bit units.
+ * @param count The number of items to read.
+ * @param data Set to the data read (free with JXFree).
+ * @return 1 if exactly count items were read, 0 otherwise.
+ */
+char ReadNetWMIconData(Window win, long offset, unsigned long count,
+                       unsigned long **data)
+{
+   unsigned long actual;
    unsigned long extra;
    Atom realType;
    int realFormat;
-   unsigned char *data;
+   int status;
    status = JXGetWindowProperty(display, win, atoms[ATOM_NET_WM_ICON],
-                                0, MAX_LENGTH, False, XA_CARDINAL,
-                                &realType, &realFormat, &count, &extra, &data);
-   if(status == Success && realFormat != 0 && data) {
-      icon = CreateIconFromBinary((unsigned long*)data, count);
+                                offset, count, False, XA_CARDINAL,
+                                &realType, &realFormat, &actual, &extra,
+                                (unsigned char**)data);
+   if(status != Success || realFormat != 32 || *data == NULL) {
+      if(status == Success && *data) {
+         JXFree(*data);
+      }
+      *data = NULL;
+      return 0;
+   }
+   if(actual != count) {
+      JXFree(*data);
+      *data = NULL;
+      return 0;
+   }
+   return 1;
+}
+
+/** Select the _NET_WM_ICON images to fetch.
+ * For each size in use, the image GetBestImage would choose is selected.
+ * If no sizes are known, only the largest image is selected.
+ */
+void SelectNetWMIcons(const unsigned long *widths,
+                      const unsigned long *heights,
+                      unsigned int count, char *selected)
+{
+   unsigned int x, y;
+   memset(selected, 0, count);
+   if(iconSizeCount == 0) {
+      unsigned int best = 0;
+      for(x = 1; x < count; x++) {
+         if(widths[x] * heights[x] > widths[best] * heights[best]) {
+            best = x;
+         }
+      }
+      selected[best] = 1;
+      return;
+   }
+   for(y = 0; y < iconSizeCount; y++) {
+      const unsigned long size = (unsigned long)iconSizes[y];
+      unsigned int best = 0;
+      for(x = 1; x < count; x++) {
+         const unsigned long bestOverlap = Min(widths[best], size)
+                                         * Min(heights[best], size);
+         const unsigned long otherOverlap = Min(widths[x], size)
+                                          * Min(heights[x], size);
+         if(otherOverlap > bestOverlap) {
+            best = x;
+         } else if(otherOverlap == bestOverlap
+                   && widths[x] * heights[x]
+                      < widths[best] * heights[best]) {
+            best = x;
+         }
+      }
+      selected[best] = 1;
+   }
+}
+
+/** Read the icon property from a client.
+ * The property usually holds many sizes of the same icon, so only the
+ * width/height headers are read first. Only the images that are the best
+ * fit for the sizes we draw are then fetched.
+ */
+IconNode *ReadNetWMIcon(Window win)
+{
+   unsigned long widths[MAX_NET_ICONS];
+   unsigned long heights[MAX_NET_ICONS];
+   long offsets[MAX_NET_ICONS];
+   char selected[MAX_NET_ICONS];
+   IconNode *icon = NULL;
+   unsigned long *data;
+   unsigned int count;
+   unsigned int i;
+   long offset;
+
+   /* Walk the image headers. */
+   count = 0;
+   offset = 0;
+   while(count < MAX_NET_ICONS && ReadNetWMIconData(win, offset, 2, &data)) {
+      const unsigned long width = data[0];
+      const unsigned long height = data[1];
       JXFree(data);
+      if(JUNLIKELY(width == 0 || height == 0
+                   || width > 0x7FFF || height > 0x7FFF)) {
+         Debug("invalid image size: %lu x %lu", width, height);
+         break;
+      }
+      widths[count] = width;
+      heights[count] = height;
+      offsets[count] = offset + 2;
+      count += 1;
+      offset += 2 + (long)(width * height);
    }
-   return icon;
+   if(count == 0) {
+      return NULL;
+   }
+
+   /* Fetch only the images we need. */
+   SelectNetWMIcons(widths, heights, count, selected);
+   for(i = 0; i < count; i++) {
+      const unsigned long pixels = widths[i] * heights[i];
+      unsigned char *dest;
+      ImageNode *image;
+      unsigned long x;
+
+      if(!selected[i]) {
+         continue;
+      }
+      if(!ReadNetWMIconData(win, offsets[i], pixels, &data)) {
+         Debug("truncated _NET_WM_ICON image: %lu x %lu",
+               widths[i], heights[i]);
+         continue;
+      }
+
+      image = CreateImage(widths[i], heights[i], 0);
+      if(icon == NULL) {
+         icon = CreateIcon(image);
+      }
+      image->next = icon->images;
+      icon->images = image;
+
+      /* Note: the data types here might be of different sizes. */
+      dest = image->data;
+      for(x = 0; x < pixels; x++) {
+         *dest++ = (data[x] >> 24) & 0xFF;
+         *dest++ = (data[x] >> 16) & 0xFF;
+         *dest++ = (data[x] >>  8) & 0xFF;
+         *dest++ = (data[x] >>  0) & 0xFF;
+      }
+      JXFree(data);
+
+   }
+
+   return ShareIcon(icon);
 }
 
 /** Read the icon WMHint property from a client. */
@@ -424,7 +776,7 @@ IconNode *ReadWMHintIcon(Window win)
       }
       JXFree(hints);
    }
-   return icon;
+   return ShareIcon(icon);
 }
 
 /** Create an icon from XPM image data. */
@@ -567,6 +919,7 @@ ScaledIconNode *GetScaledIcon(IconNode *icon, long fg,
    int scalex, scaley;     /* Fixed point. */
    int srcx, srcy;         /* Fixed point. */
    int nwidth, nheight;
+   int keyWidth, keyHeight;
    unsigned char *data;
    unsigned perLine;
 
@@ -589,26 +942,25 @@ ScaledIconNode *GetScaledIcon(IconNode *icon, long fg,
    nwidth = Max(1, nwidth);
    nheight = Max(1, nheight);
 
-   /* Check if this size already exists. */
-   for(np = icon->nodes; np; np = np->next) {
-      if(!icon->bitmap || np->fg == fg) {
+   /* If we are using xrender and only have one image size
+    * available, we can simply scale the existing icon. */
 #ifdef USE_XRENDER
-         /* If we are using xrender and only have one image size
-          * available, we can simply scale the existing icon. */
-         if(icon->render) {
-            if(icon->images == NULL || icon->images->next == NULL) {
-               return np;
-            } else {
-               if(np->renderWidth == nwidth && np->renderHeight == nheight) {
-                  return np;
-               }
-            }
-         }
+   if(icon->render && (icon->images == NULL || icon->images->next == NULL)) {
+      keyWidth = 0;
+      keyHeight = 0;
+   } else {
+      keyWidth = nwidth;
+      keyHeight = nheight;
+   }
+#else
+   keyWidth = nwidth;
+   keyHeight = nheight;
 #endif
-         if(np->width == nwidth && np->height == nheight) {
-            return np;
-         }
-      }
+
+   /* Check if this size already exists. */
+   np = FindScaledIcon(icon, fg, keyWidth, keyHeight);
+   if(np) {
+      return np;
    }
 
    /* Need to load the image. */
@@ -623,8 +975,7 @@ ScaledIconNode *GetScaledIcon(IconNode *icon, long fg,
       np = CreateScaledRenderIcon(imageNode, fg);
       np->renderWidth = nwidth;
       np->renderHeight = nheight;
-      np->next = icon->nodes;
-      icon->nodes = np;
+      InsertScaledIcon(icon, np, fg, keyWidth, keyHeight);
 
       /* Don't keep the image data around after creating the icon. */
       if(icon->images == NULL) {
@@ -640,8 +991,6 @@ ScaledIconNode *GetScaledIcon(IconNode *icon, long fg,
    np->fg = fg;
    np->width = nwidth;
    np->height = nheight;
-   np->next = icon->nodes;
-   icon->nodes = np;
 
    /* Create a mask. */
    np->mask = JXCreatePixmap(display, rootWindow, nwidth, nheight, 1);
@@ -724,61 +1073,159 @@ ScaledIconNode *GetScaledIcon(IconNode *icon, long fg,
       DestroyImage(imageNode);
    }
 
+   InsertScaledIcon(icon, np, fg, keyWidth, keyHeight);
    return np;
 
 }
 
-/** Create an icon from binary data (as specified via window properties). */
-IconNode *CreateIconFromBinary(const unsigned long *input,
-                               unsigned int length)
+/** Compute the scaled icon cache bucket for a key. */
+unsigned int GetScaledHash(const IconNode *icon, long fg,
+                           int width, int height)
 {
-   IconNode *result = NULL;
-   unsigned int offset = 0;
+   unsigned long h = (unsigned long)icon >> 4;
+   h = h * 31 + (unsigned long)width;
+   h = h * 31 + (unsigned long)height;
+   if(icon->bitmap) {
+      h = h * 31 + (unsigned long)fg;
+   }
+   h ^= h >> 16;
+   return (unsigned int)h & (SCALED_HASH_SIZE - 1);
+}
 
-   if(!input) {
-      return NULL;
+/** Look up a scaled icon, marking it as most recently used. */
+ScaledIconNode *FindScaledIcon(IconNode *icon, long fg,
+                               int width, int height)
+{
+   const unsigned int index = GetScaledHash(icon, fg, width, height);
+   ScaledIconNode *np;
+   for(np = scaledHash[index]; np; np = np->hashNext) {
+      if(np->icon == icon && np->keyWidth == width
+         && np->keyHeight == height && (!icon->bitmap || np->fg == fg)) {
+         if(np != scaledHead) {
+            np->lruPrev->lruNext = np->lruNext;
+            if(np->lruNext) {
+               np->lruNext->lruPrev = np->lruPrev;
+            } else {
+               scaledTail = np->lruPrev;
+            }
+            np->lruPrev = NULL;
+            np->lruNext = scaledHead;
+            scaledHead->lruPrev = np;
+            scaledHead = np;
+         }
+#ifdef DEBUG
+         scaledHits += 1;
+#endif
+         return np;
+      }
    }
+#ifdef DEBUG
+   scaledMisses += 1;
+#endif
+   return NULL;
+}
 
-   while(offset < length) {
+/** Add a new scaled icon to the cache.
+ * Least recently used nodes are released if this puts the cache over
+ * its budget. The new node is never released here since the caller is
+ * about to draw it.
+ */
+void InsertScaledIcon(IconNode *icon, ScaledIconNode *np, long fg,
+                      int width, int height)
+{
+   const unsigned int index = GetScaledHash(icon, fg, width, height);
+   const unsigned int pixels = np->width * np->height;
 
-      const unsigned width = input[offset + 0];
-      const unsigned height = input[offset + 1];
-      unsigned char *data;
-      ImageNode *image;
-      unsigned x;
+   np->icon = icon;
+   np->fg = fg;
+   np->keyWidth = width;
+   np->keyHeight = height;
+#ifdef USE_XRENDER
+   if(icon->render) {
+      np->bytes = pixels * 4 + pixels;
+   } else {
+      np->bytes = pixels * 4 + (pixels + 7) / 8;
+   }
+#else
+   np->bytes = pixels * 4 + (pixels + 7) / 8;
+#endif
 
-      if(JUNLIKELY(width * height + 2 > length - offset)) {
-         Debug("invalid image size: %d x %d + 2 > %d",
-               width, height, length - offset);
-         return result;
-      } else if(JUNLIKELY(width == 0 || height == 0)) {
-         Debug("invalid image size: %d x %d", width, height);
-         return result;
-      }
+   np->next = icon->nodes;
+   icon->nodes = np;
 
-      image = CreateImage(width, height, 0);
-      if(result == NULL) {
-         result = CreateIcon(image);
-      }
-      image->next = result->images;
-      result->images = image;
-      data = image->data;
+   np->hashNext = scaledHash[index];
+   scaledHash[index] = np;
 
-      /* Note: the data types here might be of different sizes. */
-      offset += 2;
-      for(x = 0; x < width * height; x++) {
-         *data++ = (input[offset] >> 24) & 0xFF;
-         *data++ = (input[offset] >> 16) & 0xFF;
-         *data++ = (input[offset] >>  8) & 0xFF;
-         *data++ = (input[offset] >>  0) & 0xFF;
-         offset += 1;
-      }
+   np->lruPrev = NULL;
+   np->lruNext = scaledHead;
+   if(scaledHead) {
+      scaledHead->lruPrev = np;
+   } else {
+      scaledTail = np;
+   }
+   scaledHead = np;
 
-      /* Don't insert this icon into the hash since it is transient. */
+   scaledBytes += np->bytes;
+#ifdef DEBUG
+   scaledPeakBytes = Max(scaledPeakBytes, scaledBytes);
+#endif
+   while(scaledBytes > SCALED_ICON_BUDGET && scaledTail != np) {
+#ifdef DEBUG
+      scaledEvictions += 1;
+#endif
+      ReleaseScaledIcon(scaledTail);
+   }
+}
+
+/** Remove a scaled icon from the cache and free it. */
+void ReleaseScaledIcon(ScaledIconNode *np)
+{
+   IconNode *icon = np->icon;
+   ScaledIconNode **pp;
 
+   pp = &scaledHash[GetScaledHash(icon, np->fg, np->keyWidth, np->keyHeight)];
+   while(*pp != np) {
+      pp = &(*pp)->hashNext;
    }
+   *pp = np->hashNext;
 
-   return result;
+   if(np->lruPrev) {
+      np->lruPrev->lruNext = np->lruNext;
+   } else {
+      scaledHead = np->lruNext;
+   }
+   if(np->lruNext) {
+      np->lruNext->lruPrev = np->lruPrev;
+   } else {
+      scaledTail = np->lruPrev;
+   }
+
+   pp = &icon->nodes;
+   while(*pp != np) {
+      pp = &(*pp)->next;
+   }
+   *pp = np->next;
+   scaledBytes -= np->bytes;
+
+#ifdef USE_XRENDER
+   if(icon->render) {
+      if(np->image != None) {
+         JXRenderFreePicture(display, np->image);
+      }
+      if(np->mask != None) {
+         JXRenderFreePicture(display, np->mask);
+      }
+   } else
+#endif
+   {
+      if(np->image != None) {
+         JXFreePixmap(display, np->image);
+      }
+      if(np->mask != None) {
+         JXFreePixmap(display, np->mask);
+      }
+   }
+   Release(np);
 }
 
 /** Create an empty icon node. */
@@ -799,6 +1246,8 @@ IconNode *CreateIcon(const ImageNode *image)
 #endif
    icon->preserveAspect = 1;
    icon->transient = 1;
+   icon->contentHash = 0;
+   icon->refCount = 0;
    return icon;
 }
 
@@ -806,56 +1255,314 @@ IconNode *CreateIcon(const ImageNode *image)
 void DoDestroyIcon(int index, IconNode *icon)
 {
    if(icon && icon != &emptyIcon) {
-      while(icon->nodes) {
-         ScaledIconNode *np = icon->nodes;
-#ifdef USE_XRENDER
-         if(icon->render) {
-            if(np->image != None) {
-               JXRenderFreePicture(display, np->image);
-            }
-            if(np->mask != None) {
-               JXRenderFreePicture(display, np->mask);
-            }
-#else
-         if(0) {
+      UnlinkIcon(iconHash, index, icon);
+      FreeIcon(icon);
+   }
+}
+
+/** Release an icon and its scaled images. */
+void FreeIcon(IconNode *icon)
+{
+   while(icon->nodes) {
+      ReleaseScaledIcon(icon->nodes);
+   }
+   DestroyImage(icon->images);
+   if(icon->name) {
+      Release(icon->name);
+   }
+   Release(icon);
+}
+
+/** Remove an icon from a hash table. */
+void UnlinkIcon(IconNode **table, unsigned int index, IconNode *icon)
+{
+   if(icon->prev) {
+      icon->prev->next = icon->next;
+   } else {
+      table[index] = icon->next;
+   }
+   if(icon->next) {
+      icon->next->prev = icon->prev;
+   }
+}
+
+/** Destroy an icon. */
+void DestroyIcon(IconNode *icon)
+{
+   if(icon && icon != &emptyIcon && icon->transient) {
+      if(icon->refCount > 1) {
+         icon->refCount -= 1;
+         return;
+      } else if(icon->refCount == 1) {
+         const unsigned int index = icon->contentHash
+                                  & (CONTENT_HASH_SIZE - 1);
+         UnlinkIcon(contentHash, index, icon);
+      }
+      FreeIcon(icon);
+   }
+}
+
+/** Get the number of bytes used by an image. */
+unsigned int GetImageSize(const ImageNode *image)
+{
+   if(image->bitmap) {
+      return (image->width * image->height + 7) / 8;
+   } else {
+      return image->width * image->height * 4;
+   }
+}
+
+/** Determine if two icons have identical images. */
+char IsSameIcon(const IconNode *a, const IconNode *b)
+{
+   const ImageNode *ap = a->images;
+   const ImageNode *bp = b->images;
+   while(ap && bp) {
+      if(ap->width != bp->width || ap->height != bp->height
+         || ap->bitmap != bp->bitmap
+         || memcmp(ap->data, bp->data, GetImageSize(ap))) {
+         return 0;
+      }
+      ap = ap->next;
+      bp = bp->next;
+   }
+   return ap == bp;
+}
+
+/** Share a client icon with other clients that have the same icon.
+ * Windows of the same application usually have identical icons. These
+ * are keyed by a hash of their contents so that only one copy of the
+ * decoded images and scaled pixmaps is kept.
+ * @param icon A new transient icon (may be NULL).
+ * @return The shared icon (icon will have been destroyed if a match
+ *         was found).
+ */
+IconNode *ShareIcon(IconNode *icon)
+{
+   const ImageNode *ip;
+   IconNode *match;
+   unsigned int hash;
+   unsigned int index;
+
+   if(icon == NULL) {
+      return NULL;
+   }
+   Assert(icon->transient);
+   Assert(icon->refCount == 0);
+
+   hash = 0;
+   for(ip = icon->images; ip; ip = ip->next) {
+      hash = hash * 31 + ((unsigned int)ip->width << 16) + ip->height;
+      hash ^= HashData(ip->data, GetImageSize(ip));
+   }
+   index = hash & (CONTENT_HASH_SIZE - 1);
+
+#ifdef DEBUG
+   sharedIconLoads += 1;
 #endif
-         } else {
-            if(np->image != None) {
-               JXFreePixmap(display, np->image);
+   for(match = contentHash[index]; match; match = match->next) {
+      if(match->contentHash == hash && IsSameIcon(match, icon)) {
+#ifdef DEBUG
+         const ScaledIconNode *sp;
+         for(ip = icon->images; ip; ip = ip->next) {
+            sharedBytesSaved += GetImageSize(ip);
+         }
+         for(sp = match->nodes; sp; sp = sp->next) {
+            sharedBytesSaved += sp->bytes;
+         }
+         sharedIconHits += 1;
+#endif
+         match->refCount += 1;
+         FreeIcon(icon);
+         return match;
+      }
+   }
+
+   icon->contentHash = hash;
+   icon->refCount = 1;
+   icon->prev = NULL;
+   icon->next = contentHash[index];
+   if(contentHash[index]) {
+      contentHash[index]->prev = icon;
+   }
+   contentHash[index] = icon;
+   return icon;
+}
+
+#ifdef USE_ICON_INDEX
+
+/** Start watching and indexing the icon paths. */
+void StartupIconIndex(void)
+{
+   const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                       | IN_MOVED_TO | IN_CLOSE_WRITE | IN_DELETE_SELF
+                       | IN_MOVE_SELF | IN_ONLYDIR;
+   IconPathNode *ip;
+
+   iconNotify = inotify_init();
+   if(JUNLIKELY(iconNotify < 0)) {
+      return;
+   }
+   if(fcntl(iconNotify, F_SETFL, O_NONBLOCK) == -1
+      || fcntl(iconNotify, F_SETFD, FD_CLOEXEC) == -1) {
+      close(iconNotify);
+      iconNotify = -1;
+      return;
+   }
+   missingNames = CreateNameTable();
+   for(ip = iconPaths; ip; ip = ip->next) {
+      ip->watch = inotify_add_watch(iconNotify, ip->path, mask);
+      if(ip->watch >= 0) {
+         IndexIconPath(ip);
+      }
+   }
+}
+
+/** Stop watching the icon paths and release the indexes. */
+void ShutdownIconIndex(void)
+{
+   IconPathNode *ip;
+   for(ip = iconPaths; ip; ip = ip->next) {
+      if(ip->names) {
+         DestroyNameTable(ip->names);
+         ip->names = NULL;
+      }
+      ip->watch = -1;
+   }
+   if(missingNames) {
+      DestroyNameTable(missingNames);
+      missingNames = NULL;
+   }
+   if(iconNotify >= 0) {
+      close(iconNotify);
+      iconNotify = -1;
+   }
+}
+
+/** Apply pending changes to the icon directories.
+ * This is a single non-blocking read when nothing has changed.
+ */
+void ProcessIconNotify(void)
+{
+   union {
+      struct inotify_event event;
+      char data[4096];
+   } buffer;
+   IconPathNode *ip;
+   char changed = 0;
+   ssize_t len;
+
+   if(iconNotify < 0) {
+      return;
+   }
+   while((len = read(iconNotify, buffer.data, sizeof(buffer))) > 0) {
+      ssize_t offset = 0;
+      while(offset < len) {
+         const struct inotify_event *ep;
+         ep = (const struct inotify_event*)&buffer.data[offset];
+
+         /* Duplicate or aliased paths share a watch, so every match is
+          * updated. After a queue overflow all directories are read
+          * again since events were lost. */
+         for(ip = iconPaths; ip; ip = ip->next) {
+            if(ip->watch == ep->wd && ip->watch >= 0) {
+               if(ep->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                  /* The directory is gone; fall back to probing. */
+                  ip->watch = -1;
+               }
+            } else if(!(ep->mask & IN_Q_OVERFLOW)) {
+               continue;
             }
-            if(np->mask != None) {
-               JXFreePixmap(display, np->mask);
+            if(ip->names) {
+               DestroyNameTable(ip->names);
+               ip->names = NULL;
             }
+            changed = 1;
+         }
+         if(ep->mask & IN_Q_OVERFLOW) {
+            changed = 1;
          }
-         icon->nodes = np->next;
-         Release(np);
+         offset += sizeof(struct inotify_event) + ep->len;
       }
-      DestroyImage(icon->images);
-      if(icon->name) {
-         Release(icon->name);
+   }
+   if(changed) {
+      DestroyNameTable(missingNames);
+      missingNames = CreateNameTable();
+      for(ip = iconPaths; ip; ip = ip->next) {
+         if(ip->watch >= 0 && !ip->names) {
+            IndexIconPath(ip);
+         }
       }
+   }
+}
 
-      if(icon->prev) {
-         icon->prev->next = icon->next;
-      } else {
-         iconHash[index] = icon->next;
+/** Read the file names in an icon directory. */
+void IndexIconPath(IconPathNode *ip)
+{
+   DIR *dir;
+   struct dirent *ep;
+
+   dir = opendir(ip->path);
+   if(JUNLIKELY(!dir)) {
+      return;
+   }
+   ip->names = CreateNameTable();
+   while((ep = readdir(dir)) != NULL) {
+      if(ep->d_name[0] != '.') {
+         AddName(ip->names, ep->d_name);
       }
-      if(icon->next) {
-         icon->next->prev = icon->prev;
+   }
+   closedir(dir);
+}
+
+/** Create an empty name table. */
+IconNameNode **CreateNameTable(void)
+{
+   IconNameNode **table = Allocate(sizeof(IconNameNode*) * NAME_HASH_SIZE);
+   memset(table, 0, sizeof(IconNameNode*) * NAME_HASH_SIZE);
+   return table;
+}
+
+/** Release a name table. */
+void DestroyNameTable(IconNameNode **table)
+{
+   unsigned int x;
+   for(x = 0; x < NAME_HASH_SIZE; x++) {
+      while(table[x]) {
+         IconNameNode *np = table[x]->next;
+         Release(table[x]);
+         table[x] = np;
       }
-      Release(icon);
    }
+   Release(table);
 }
 
-/** Destroy an icon. */
-void DestroyIcon(IconNode *icon)
+/** Add a name to a name table. */
+void AddName(IconNameNode **table, const char *name)
 {
-   if(icon && icon->transient) {
-      const unsigned int index = GetHash(icon->name);
-      DoDestroyIcon(index, icon);
+   const unsigned int index = HashString(name) & (NAME_HASH_SIZE - 1);
+   const size_t len = strlen(name);
+   IconNameNode *np = Allocate(sizeof(IconNameNode) + len);
+   memcpy(np->name, name, len + 1);
+   np->next = table[index];
+   table[index] = np;
+}
+
+/** Determine if a name is in a name table. */
+char HasName(IconNameNode **table, const char *name)
+{
+   const unsigned int index = HashString(name) & (NAME_HASH_SIZE - 1);
+   const IconNameNode *np;
+   for(np = table[index]; np; np = np->next) {
+      if(!strcmp(np->name, name)) {
+         return 1;
+      }
    }
+   return 0;
 }
 
+#endif /* USE_ICON_INDEX */
+
 /** Insert an icon to the icon hash table. */
 void InsertIcon(IconNode *icon)
 {
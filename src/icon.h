@@ -26,7 +26,15 @@ typedef struct ScaledIconNode {
    XID image;
    XID mask;
 
-   struct ScaledIconNode *next;
+   struct IconNode *icon;  /**< The icon this node was scaled from. */
+   int keyWidth;           /**< Requested width (cache key). */
+   int keyHeight;          /**< Requested height (cache key). */
+   unsigned int bytes;     /**< Estimated server memory used. */
+
+   struct ScaledIconNode *next;     /**< Next scaled node for the icon. */
+   struct ScaledIconNode *hashNext; /**< Next node in the cache bucket. */
+   struct ScaledIconNode *lruPrev;  /**< More recently used node. */
+   struct ScaledIconNode *lruNext;  /**< Less recently used node. */
 
 } ScaledIconNode;
 
@@ -46,6 +54,9 @@ typedef struct IconNode {
                                    *   of the icon when scaling. */
    char bitmap;                   /**< Set if this is a bitmap. */
    char transient;                /**< Set if this icon is transient. */
+   unsigned int contentHash;      /**< Hash of the image contents. */
+   unsigned int refCount;         /**< References to a shared icon
+                                   *   (0 if not shared). */
 #ifdef USE_XRENDER
    char render;                   /**< Set to use render. */
 #endif
@@ -67,7 +78,7 @@ void DestroyIcons(void);
  * This adds a path to the list of icon search paths.
  * @param path The icon path to add.
  */
-void AddIconPath(char *path);
+void AddIconPath(const char *path);
 
 /** Render an icon.
  * This will scale an icon if necessary to fit the requested size. The
@@ -109,6 +120,12 @@ void DestroyIcon(IconNode *icon);
 /** Set the default icon. */
 void SetDefaultIcon(const char *name);
 
+/** Register a size at which icons are drawn.
+ * Only the best images for registered sizes are read from _NET_WM_ICON.
+ * @param size The icon size in pixels.
+ */
+void RequestIconSize(int size);
+
 #else
 
 #define ICON_DUMMY_FUNCTION ((void)0)
@@ -124,6 +141,7 @@ void SetDefaultIcon(const char *name);
 #define LoadNamedIcon( a, b, c )           NULL
 #define DestroyIcon( a )                   ICON_DUMMY_FUNCTION
 #define SetDefaultIcon( a )                ICON_DUMMY_FUNCTION
+#define RequestIconSize( a )               ICON_DUMMY_FUNCTION
 
 #endif /* USE_ICONS */
 
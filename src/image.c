@@ -33,6 +33,7 @@
 #include "error.h"
 #include "color.h"
 #include "misc.h"
+#include "imagecache.h"
 
 typedef ImageNode *(*ImageLoader)(const char *fileName,
                                   int rwidth, int rheight,
@@ -119,6 +120,12 @@ ImageNode *LoadImage(const char *fileName, int rwidth, int rheight,
       return result;
    }
 
+   /* Check for an already decoded image. */
+   result = LoadCachedImage(fileName, rwidth, rheight, preserveAspect);
+   if(result) {
+      return result;
+   }
+
    /* First we attempt to use the extension to determine the type
     * to avoid trying all loaders. */
    for(i = 0; i < IMAGE_LOADER_COUNT; i++) {
@@ -130,6 +137,7 @@ ImageNode *LoadImage(const char *fileName, int rwidth, int rheight,
             const ImageLoader loader = IMAGE_LOADERS[i].loader;
             result = (loader)(fileName, rwidth, rheight, preserveAspect);
             if(JLIKELY(result)) {
+               CacheImage(fileName, rwidth, rheight, preserveAspect, result);
                return result;
             }
             break;
@@ -146,6 +154,7 @@ ImageNode *LoadImage(const char *fileName, int rwidth, int rheight,
           * wrong extension or an extension we don't recognize. */
          Warning(_("unrecognized extension for \"%s\", expected \"%s\""),
                  fileName, IMAGE_LOADERS[i].extension);
+         CacheImage(fileName, rwidth, rheight, preserveAspect, result);
          return result;
       }
    }
@@ -676,6 +685,7 @@ ImageNode *CreateImage(unsigned width, unsigned height, char bitmap)
    image->data = Allocate(image_size);
    image->next = NULL;
    image->bitmap = bitmap;
+   image->mapped = 0;
    image->width = width;
    image->height = height;
 #ifdef USE_XRENDER
@@ -688,7 +698,7 @@ ImageNode *CreateImage(unsigned width, unsigned height, char bitmap)
 void DestroyImage(ImageNode *image) {
    while(image) {
       ImageNode *next = image->next;
-      if(image->data) {
+      if(image->data && !image->mapped) {
          Release(image->data);
       }
       Release(image);
@@ -18,6 +18,7 @@ typedef struct ImageNode {
    int width;                    /**< Width of the image. */
    int height;                   /**< Height of the image. */
    char bitmap;                  /**< 1 if a bitmap, 0 otherwise. */
+   char mapped;                  /**< 1 if data is in the image cache. */
 #ifdef USE_XRENDER
    char render;                  /**< 1 to use render, 0 otherwise. */
 #endif
@@ -0,0 +1,557 @@
+/**
+ * @file imagecache.c
+ *
+ * @brief Persistent cache of decoded images.
+ *
+ * Decoded images are stored in a single file under $XDG_CACHE_HOME/jwm
+ * (or ~/.cache/jwm). The file is mapped on startup and cached images
+ * point directly into the mapping. Entries are keyed by the file name,
+ * its inode, size, and modification and change times, and the requested
+ * dimensions. New images are collected in memory and the file is
+ * rewritten on shutdown, dropping entries for files that changed or
+ * disappeared, entries not used for MAX_UNUSED_WRITES rewrites, and the
+ * least recently used entries beyond MAX_CACHE_BYTES.
+ *
+ * File layout (native byte order; the cache is local to the machine):
+ *  - CacheHeader
+ *  - CacheEntry[count], sorted by hash
+ *  - NUL-terminated file names
+ *  - Image data, each block aligned to 8 bytes
+ *
+ */
+
+#include "jwm.h"
+#include "imagecache.h"
+#include "image.h"
+#include "main.h"
+#include "misc.h"
+#include "error.h"
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/** Identifies a cache file; change the version if the layout changes. */
+static const char CACHE_MAGIC[8] = "JWMIMGC";
+#define CACHE_VERSION 2
+
+/** Largest image dimension accepted from the cache file (the X limit). */
+#define MAX_IMAGE_DIMENSION 32767
+
+/** Maximum bytes of new images to hold until shutdown. */
+#define MAX_PENDING_BYTES (16 << 20)
+
+/** Maximum bytes of image data in the cache file. */
+#define MAX_CACHE_BYTES (64 << 20)
+
+/** Entries not used for this many rewrites are dropped. */
+#define MAX_UNUSED_WRITES 8
+
+typedef struct CacheHeader {
+   char magic[8];
+   unsigned int version;
+   unsigned int entrySize;    /**< sizeof(CacheEntry). */
+   unsigned int count;        /**< Number of entries. */
+   unsigned int reserved;
+} CacheHeader;
+
+typedef struct CacheEntry {
+   FileKey key;               /**< The version of the file. */
+   unsigned int hash;         /**< Hash of the key. */
+   unsigned int nameOffset;   /**< Offset of the file name. */
+   unsigned int dataOffset;   /**< Offset of the image data. */
+   unsigned int dataSize;     /**< Size of the image data. */
+   int rwidth;                /**< Requested width. */
+   int rheight;               /**< Requested height. */
+   int width;                 /**< Decoded width. */
+   int height;                /**< Decoded height. */
+   char bitmap;               /**< Set if the image is a bitmap. */
+   char preserveAspect;       /**< Set if the aspect was preserved. */
+   unsigned char age;         /**< Rewrites since the entry was used. */
+   char reserved[5];
+} CacheEntry;
+
+/** An image added this session (or kept from the old file). */
+typedef struct PendingImage {
+   CacheEntry entry;
+   const char *name;
+   const unsigned char *data;
+   struct PendingImage *next;
+} PendingImage;
+
+static char *cachePath = NULL;
+static unsigned char *cacheData = NULL;
+static size_t cacheSize = 0;
+static const CacheEntry *cacheEntries = NULL;
+static unsigned int cacheCount = 0;
+static char *cacheUsed = NULL;
+
+static PendingImage *pending = NULL;
+static size_t pendingBytes = 0;
+
+static void OpenCache(void);
+static void CloseCache(void);
+static char ValidateCache(void);
+static unsigned int GetKeyHash(const char *fileName, const FileKey *key,
+                               int rwidth, int rheight, char preserveAspect);
+static char IsMatch(const CacheEntry *ep, const char *name,
+                    const FileKey *key, int rwidth, int rheight,
+                    char preserveAspect);
+static unsigned int GetDataSize(const ImageNode *image);
+static void WriteImageCache(char aging);
+static int EntryCompare(const void *a, const void *b);
+static void ReleasePending(void);
+static void ReleaseKept(PendingImage *kept);
+
+/** Start the image cache. */
+void StartupImageCache(void)
+{
+   cachePath = GetCachePath("images");
+   OpenCache();
+}
+
+/** Shutdown the image cache.
+ * This must be called after all images have been destroyed.
+ */
+void ShutdownImageCache(void)
+{
+   if(pending) {
+      WriteImageCache(1);
+   }
+   ReleasePending();
+   CloseCache();
+   if(cachePath) {
+      Release(cachePath);
+      cachePath = NULL;
+   }
+}
+
+/** Remove out of date entries from the cache file. */
+void PruneImageCache(void)
+{
+   StartupImageCache();
+   if(cacheData) {
+      WriteImageCache(0);
+   }
+   ShutdownImageCache();
+}
+
+/** Remove the cache file. */
+void ClearImageCache(void)
+{
+   char *path = GetCachePath("images");
+   if(path) {
+      if(unlink(path) < 0 && errno != ENOENT) {
+         Warning(_("could not remove %s: %s"), path, strerror(errno));
+      }
+      Release(path);
+   }
+}
+
+/** Map the cache file. */
+void OpenCache(void)
+{
+   struct stat st;
+   void *data;
+   int fd;
+
+   if(!cachePath) {
+      return;
+   }
+   fd = open(cachePath, O_RDONLY);
+   if(fd < 0) {
+      return;
+   }
+   if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(CacheHeader)) {
+      close(fd);
+      return;
+   }
+
+   /* Private and writable so a stray write can never reach the file. */
+   data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(data == MAP_FAILED) {
+      return;
+   }
+   cacheData = data;
+   cacheSize = st.st_size;
+   if(!ValidateCache()) {
+      Debug("ignoring invalid image cache %s", cachePath);
+      CloseCache();
+      return;
+   }
+   cacheUsed = Allocate(cacheCount + 1);
+   memset(cacheUsed, 0, cacheCount + 1);
+}
+
+/** Unmap the cache file. */
+void CloseCache(void)
+{
+   if(cacheData) {
+      munmap(cacheData, cacheSize);
+      cacheData = NULL;
+   }
+   if(cacheUsed) {
+      Release(cacheUsed);
+      cacheUsed = NULL;
+   }
+   cacheSize = 0;
+   cacheEntries = NULL;
+   cacheCount = 0;
+}
+
+/** Check that the mapped cache file is well-formed. */
+char ValidateCache(void)
+{
+   const CacheHeader *header = (const CacheHeader*)cacheData;
+   size_t pixels;
+   unsigned int x;
+
+   if(memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC))
+      || header->version != CACHE_VERSION
+      || header->entrySize != sizeof(CacheEntry)) {
+      return 0;
+   }
+   if(header->count > (cacheSize - sizeof(CacheHeader)) / sizeof(CacheEntry)) {
+      return 0;
+   }
+   cacheEntries = (const CacheEntry*)(cacheData + sizeof(CacheHeader));
+   cacheCount = header->count;
+   for(x = 0; x < cacheCount; x++) {
+      const CacheEntry *ep = &cacheEntries[x];
+      if(ep->nameOffset >= cacheSize
+         || !memchr(cacheData + ep->nameOffset, 0,
+                    cacheSize - ep->nameOffset)) {
+         return 0;
+      }
+      if(ep->dataOffset > cacheSize
+         || ep->dataSize > cacheSize - ep->dataOffset
+         || (ep->dataOffset & 7) != 0) {
+         return 0;
+      }
+      if(ep->width <= 0 || ep->height <= 0
+         || ep->width > MAX_IMAGE_DIMENSION
+         || ep->height > MAX_IMAGE_DIMENSION) {
+         return 0;
+      }
+      pixels = (size_t)ep->width * (size_t)ep->height;
+      if(ep->bitmap) {
+         if((size_t)ep->dataSize != (pixels + 7) / 8) {
+            return 0;
+         }
+      } else if((size_t)ep->dataSize != pixels * 4) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/** Compute the hash of a cache key. */
+unsigned int GetKeyHash(const char *fileName, const FileKey *key,
+                        int rwidth, int rheight, char preserveAspect)
+{
+   unsigned int hash = HashString(fileName);
+   hash = hash * 31 + HashData(key, sizeof(FileKey));
+   hash = hash * 31 + (unsigned int)rwidth;
+   hash = hash * 31 + (unsigned int)rheight;
+   hash = hash * 31 + (unsigned int)preserveAspect;
+   return hash;
+}
+
+/** Determine if a cache entry matches a key. */
+char IsMatch(const CacheEntry *ep, const char *name, const FileKey *key,
+             int rwidth, int rheight, char preserveAspect)
+{
+   return !memcmp(&ep->key, key, sizeof(FileKey))
+       && ep->rwidth == rwidth
+       && ep->rheight == rheight
+       && ep->preserveAspect == preserveAspect
+       && !strcmp(name, (const char*)cacheData + ep->nameOffset);
+}
+
+/** Get the size of the data for an image. */
+unsigned int GetDataSize(const ImageNode *image)
+{
+   if(image->bitmap) {
+      return (image->width * image->height + 7) / 8;
+   } else {
+      return image->width * image->height * 4;
+   }
+}
+
+/** Look up a decoded image in the cache. */
+ImageNode *LoadCachedImage(const char *fileName, int rwidth, int rheight,
+                           char preserveAspect)
+{
+   struct stat st;
+   FileKey key;
+   unsigned int hash;
+   unsigned int low, high;
+
+   if(!cacheData || stat(fileName, &st) < 0) {
+      return NULL;
+   }
+   GetFileKey(&st, &key);
+   hash = GetKeyHash(fileName, &key, rwidth, rheight, preserveAspect);
+
+   /* Find the first entry with this hash. */
+   low = 0;
+   high = cacheCount;
+   while(low < high) {
+      const unsigned int mid = low + (high - low) / 2;
+      if(cacheEntries[mid].hash < hash) {
+         low = mid + 1;
+      } else {
+         high = mid;
+      }
+   }
+
+   for(; low < cacheCount && cacheEntries[low].hash == hash; low++) {
+      const CacheEntry *ep = &cacheEntries[low];
+      if(IsMatch(ep, fileName, &key, rwidth, rheight, preserveAspect)) {
+         ImageNode *image = Allocate(sizeof(ImageNode));
+         image->next = NULL;
+         image->data = cacheData + ep->dataOffset;
+         image->width = ep->width;
+         image->height = ep->height;
+         image->bitmap = ep->bitmap;
+         image->mapped = 1;
+#ifdef USE_XRENDER
+         image->render = ep->bitmap ? 0 : haveRender;
+#endif
+         cacheUsed[low] = 1;
+         return image;
+      }
+   }
+   return NULL;
+}
+
+/** Add a decoded image to the cache. */
+void CacheImage(const char *fileName, int rwidth, int rheight,
+                char preserveAspect, const ImageNode *image)
+{
+   const unsigned int dataSize = GetDataSize(image);
+   PendingImage *pp;
+   unsigned char *data;
+   struct stat st;
+   FileKey key;
+   unsigned int hash;
+
+   if(!cachePath || image->next || dataSize == 0) {
+      return;
+   }
+   if(pendingBytes + dataSize > MAX_PENDING_BYTES) {
+      return;
+   }
+   if(stat(fileName, &st) < 0 || IsFileRecent(&st)) {
+      return;
+   }
+   GetFileKey(&st, &key);
+   hash = GetKeyHash(fileName, &key, rwidth, rheight, preserveAspect);
+   for(pp = pending; pp; pp = pp->next) {
+      if(pp->entry.hash == hash && pp->entry.rwidth == rwidth
+         && pp->entry.rheight == rheight
+         && pp->entry.preserveAspect == preserveAspect
+         && !strcmp(pp->name, fileName)) {
+         return;
+      }
+   }
+
+   pp = Allocate(sizeof(PendingImage));
+   memset(&pp->entry, 0, sizeof(pp->entry));
+   pp->entry.key = key;
+   pp->entry.hash = hash;
+   pp->entry.dataSize = dataSize;
+   pp->entry.rwidth = rwidth;
+   pp->entry.rheight = rheight;
+   pp->entry.width = image->width;
+   pp->entry.height = image->height;
+   pp->entry.bitmap = image->bitmap;
+   pp->entry.preserveAspect = preserveAspect;
+   pp->name = CopyString(fileName);
+   data = Allocate(dataSize);
+   memcpy(data, image->data, dataSize);
+   pp->data = data;
+   pp->next = pending;
+   pending = pp;
+   pendingBytes += dataSize;
+}
+
+/** Compare cache entries by hash for qsort. */
+int EntryCompare(const void *a, const void *b)
+{
+   const PendingImage *pa = *(const PendingImage**)a;
+   const PendingImage *pb = *(const PendingImage**)b;
+   if(pa->entry.hash < pb->entry.hash) {
+      return -1;
+   } else if(pa->entry.hash > pb->entry.hash) {
+      return 1;
+   } else {
+      return 0;
+   }
+}
+
+/** Release images waiting to be written. */
+void ReleasePending(void)
+{
+   while(pending) {
+      PendingImage *next = pending->next;
+      char *name = (char*)pending->name;
+      unsigned char *data = (unsigned char*)pending->data;
+      Release(name);
+      Release(data);
+      Release(pending);
+      pending = next;
+   }
+   pendingBytes = 0;
+}
+
+/** Write the cache file.
+ * Entries from the old file that were not used this session are only
+ * kept if their file is unchanged and they have not gone unused for
+ * too long. Entries are then kept by age until the size limit.
+ * @param aging Set to count this as a rewrite for unused entries.
+ */
+void WriteImageCache(char aging)
+{
+   static const char PADDING[8] = { 0 };
+   PendingImage **items;
+   PendingImage *kept;
+   PendingImage *pp;
+   CacheHeader header;
+   unsigned int count;
+   unsigned int nameOffset;
+   unsigned int dataOffset;
+   unsigned int x;
+   size_t totalBytes;
+   int age;
+   char *tempPath;
+   FILE *fd;
+
+   if(!cachePath) {
+      return;
+   }
+
+   /* Collect entries from the old file that are still valid,
+    * most recently used first, until the size limit is reached. */
+   kept = NULL;
+   totalBytes = pendingBytes;
+   for(age = 0; age < MAX_UNUSED_WRITES; age++) {
+      for(x = 0; x < cacheCount; x++) {
+         const CacheEntry *ep = &cacheEntries[x];
+         const char *name = (const char*)cacheData + ep->nameOffset;
+         int newAge = ep->age;
+         if(cacheUsed[x]) {
+            newAge = 0;
+         } else if(aging) {
+            newAge += 1;
+         }
+         if(newAge != age) {
+            continue;
+         }
+         if(!cacheUsed[x]) {
+            struct stat st;
+            FileKey key;
+            if(stat(name, &st) < 0) {
+               continue;
+            }
+            GetFileKey(&st, &key);
+            if(memcmp(&ep->key, &key, sizeof(FileKey))) {
+               continue;
+            }
+         }
+         if(totalBytes + ep->dataSize > MAX_CACHE_BYTES) {
+            continue;
+         }
+         totalBytes += ep->dataSize;
+         pp = Allocate(sizeof(PendingImage));
+         pp->entry = *ep;
+         pp->entry.age = (unsigned char)newAge;
+         pp->name = name;
+         pp->data = cacheData + ep->dataOffset;
+         pp->next = kept;
+         kept = pp;
+      }
+   }
+
+   /* Sort by hash. */
+   count = 0;
+   for(pp = pending; pp; pp = pp->next) {
+      count += 1;
+   }
+   for(pp = kept; pp; pp = pp->next) {
+      count += 1;
+   }
+   items = Allocate(sizeof(PendingImage*) * (count + 1));
+   count = 0;
+   for(pp = pending; pp; pp = pp->next) {
+      items[count] = pp;
+      count += 1;
+   }
+   for(pp = kept; pp; pp = pp->next) {
+      items[count] = pp;
+      count += 1;
+   }
+   qsort(items, count, sizeof(PendingImage*), EntryCompare);
+
+   /* Assign offsets. */
+   nameOffset = sizeof(CacheHeader) + count * sizeof(CacheEntry);
+   dataOffset = nameOffset;
+   for(x = 0; x < count; x++) {
+      dataOffset += strlen(items[x]->name) + 1;
+   }
+   for(x = 0; x < count; x++) {
+      items[x]->entry.nameOffset = nameOffset;
+      nameOffset += strlen(items[x]->name) + 1;
+      dataOffset = (dataOffset + 7) & ~7U;
+      items[x]->entry.dataOffset = dataOffset;
+      dataOffset += items[x]->entry.dataSize;
+   }
+
+   /* Write to a new file and rename it into place.
+    * The old file stays mapped until we are done with it. */
+   fd = CreateReplacement(cachePath, &tempPath);
+   if(JUNLIKELY(!fd)) {
+      Debug("could not write image cache %s", cachePath);
+      Release(items);
+      ReleaseKept(kept);
+      return;
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+   header.version = CACHE_VERSION;
+   header.entrySize = sizeof(CacheEntry);
+   header.count = count;
+   fwrite(&header, sizeof(header), 1, fd);
+   for(x = 0; x < count; x++) {
+      fwrite(&items[x]->entry, sizeof(CacheEntry), 1, fd);
+   }
+   for(x = 0; x < count; x++) {
+      fwrite(items[x]->name, strlen(items[x]->name) + 1, 1, fd);
+   }
+   for(x = 0; x < count; x++) {
+      const long offset = ftell(fd);
+      fwrite(PADDING, items[x]->entry.dataOffset - offset, 1, fd);
+      fwrite(items[x]->data, items[x]->entry.dataSize, 1, fd);
+   }
+
+   ReplaceFile(fd, tempPath, cachePath);
+   Release(items);
+   ReleaseKept(kept);
+}
+
+/** Release entries kept from the old file. */
+void ReleaseKept(PendingImage *kept)
+{
+   while(kept) {
+      PendingImage *next = kept->next;
+      Release(kept);
+      kept = next;
+   }
+}
+
+#endif /* HAVE_SYS_MMAN_H && HAVE_SYS_STAT_H */
@@ -0,0 +1,68 @@
+/**
+ * @file imagecache.h
+ *
+ * @brief Persistent cache of decoded images.
+ *
+ */
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+struct ImageNode;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+
+/*@{*/
+#define InitializeImageCache()   (void)(0)
+void StartupImageCache(void);
+void ShutdownImageCache(void);
+#define DestroyImageCache()      (void)(0)
+/*@}*/
+
+/** Look up a decoded image in the cache.
+ * The image data is mapped from the cache file and is not copied.
+ * @param fileName The image file.
+ * @param rwidth The requested width.
+ * @param rheight The requested height.
+ * @param preserveAspect Set if the aspect ratio was preserved.
+ * @return The image (NULL if not cached or out of date).
+ */
+struct ImageNode *LoadCachedImage(const char *fileName,
+                                  int rwidth, int rheight,
+                                  char preserveAspect);
+
+/** Add a decoded image to the cache.
+ * The cache file is written on shutdown.
+ * @param fileName The image file.
+ * @param rwidth The requested width.
+ * @param rheight The requested height.
+ * @param preserveAspect Set if the aspect ratio was preserved.
+ * @param image The decoded image.
+ */
+void CacheImage(const char *fileName, int rwidth, int rheight,
+                char preserveAspect, const struct ImageNode *image);
+
+/** Remove out of date entries from the cache file.
+ * This is used for the -prunecache option and does not need X.
+ */
+void PruneImageCache(void);
+
+/** Remove the cache file so that it is rebuilt on the next start.
+ * This is used for the -clearcache option and does not need X.
+ */
+void ClearImageCache(void);
+
+#else
+
+#define InitializeImageCache()            (void)(0)
+#define StartupImageCache()               (void)(0)
+#define ShutdownImageCache()              (void)(0)
+#define DestroyImageCache()               (void)(0)
+#define LoadCachedImage( a, b, c, d )     NULL
+#define CacheImage( a, b, c, d, e )       (void)(0)
+#define PruneImageCache()                 (void)(0)
+#define ClearImageCache()                 (void)(0)
+
+#endif
+
+#endif /* IMAGECACHE_H */
@@ -59,6 +59,12 @@
 #  ifdef HAVE_SYS_SELECT_H
 #     include <sys/select.h>
 #  endif
+#  ifdef HAVE_DIRENT_H
+#     include <dirent.h>
+#  endif
+#  ifdef HAVE_SYS_INOTIFY_H
+#     include <sys/inotify.h>
+#  endif
 
 #  include <X11/Xlib.h>
 #  ifdef HAVE_X11_XUTIL_H
@@ -100,6 +106,10 @@
 #  ifdef USE_XRENDER
 #     include <X11/extensions/Xrender.h>
 #  endif
+#  ifdef USE_XCOMPOSITE
+#     include <X11/extensions/Xcomposite.h>
+#     include <X11/extensions/Xdamage.h>
+#  endif
 
 #endif /* MAKE_DEPEND */
 
@@ -121,6 +131,7 @@
 #define MOVE_DELTA         3     /**< Pixels before trigging a move. */
 #define RESTART_DELAY      1000  /**< Max timeout in ms before restarting. */
 #define URGENCY_DELAY      500   /**< Flash timeout in ms for urgency. */
+#define TITLE_UPDATE_DELAY 100   /**< Min ms between title redraws. */
 #define MENU_TIMEOUT_MS    5000  /**< Default menu pipe timeout. */
 #define INCLUDE_TIMEOUT_MS 60000 /**< Default include pipe timeout. */
 
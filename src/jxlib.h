@@ -79,6 +79,8 @@
 #define JXChangeWindowAttributes( a, b, c, d ) \
    JFUNC4(XChangeWindowAttributes, a, b, c, d)
 
+#define JXCheckIfEvent( a, b, c, d ) JFUNC4(XCheckIfEvent, a, b, c, d)
+
 #define JXCheckTypedEvent( a, b, c ) JFUNC3(XCheckTypedEvent, a, b, c)
 
 #define JXCheckTypedWindowEvent( a, b, c, d ) \
@@ -232,6 +234,9 @@
 
 #define JXLoadQueryFont( a, b ) JFUNC2(XLoadQueryFont, a, b)
 
+#define JXLookupString( a, b, c, d, e ) \
+   JFUNC5(XLookupString, a, b, c, d, e)
+
 #define JXMapRaised( a, b ) JFUNC2(XMapRaised, a, b)
 
 #define JXMapWindow( a, b ) JFUNC2(XMapWindow, a, b)
@@ -415,4 +420,32 @@
 #define JXRenderComposite( a, b, c, d, e, f, g, h, i, j, k, l, m ) \
    JFUNC13(XRenderComposite, a, b, c, d, e, f, g, h, i, j, k, l, m)
 
+/* Xcomposite */
+
+#define JXCompositeQueryExtension( a, b, c ) \
+   JFUNC3(XCompositeQueryExtension, a, b, c)
+
+#define JXCompositeQueryVersion( a, b, c ) \
+   JFUNC3(XCompositeQueryVersion, a, b, c)
+
+#define JXCompositeRedirectWindow( a, b, c ) \
+   JFUNC3(XCompositeRedirectWindow, a, b, c)
+
+#define JXCompositeUnredirectWindow( a, b, c ) \
+   JFUNC3(XCompositeUnredirectWindow, a, b, c)
+
+#define JXCompositeNameWindowPixmap( a, b ) \
+   JFUNC2(XCompositeNameWindowPixmap, a, b)
+
+/* Xdamage */
+
+#define JXDamageQueryExtension( a, b, c ) \
+   JFUNC3(XDamageQueryExtension, a, b, c)
+
+#define JXDamageCreate( a, b, c ) JFUNC3(XDamageCreate, a, b, c)
+
+#define JXDamageDestroy( a, b ) JFUNC2(XDamageDestroy, a, b)
+
+#define JXDamageSubtract( a, b, c, d ) JFUNC4(XDamageSubtract, a, b, c, d)
+
 #endif /* JXLIB_H */
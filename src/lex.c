@@ -12,8 +12,83 @@
 #include "error.h"
 #include "misc.h"
 
-/** Amount to increase allocations by when reading text. */
-static const int BLOCK_SIZE = 16;
+/** Initial size of the buffer used when reading text. */
+static const unsigned int BUFFER_SIZE = 256;
+
+/** Size of the blocks holding a token tree. */
+static const size_t TOKEN_BLOCK_SIZE = 16384;
+
+/** Number of hash buckets for interned strings. */
+static const unsigned int STRING_HASH_SIZE = 1024;
+
+/** Block of memory for a token tree.
+ * The data follows the header.
+ */
+typedef struct TokenBlock {
+   struct TokenBlock *next;   /**< Next (older) block. */
+   size_t used;               /**< Bytes used. */
+   size_t size;               /**< Bytes available. */
+} TokenBlock;
+
+/** An interned string. */
+typedef struct StringNode {
+   struct StringNode *next;
+   const char *str;
+} StringNode;
+
+/** Memory for a token tree.
+ * Nodes and strings are carved out of large blocks and the whole tree
+ * is released at once. Attribute names and values are interned since
+ * the same ones occur over and over.
+ */
+typedef struct TokenArena {
+   TokenBlock *blocks;        /**< Blocks (newest first). */
+   StringNode **strings;      /**< Interned strings (while tokenizing). */
+   char *buffer;              /**< Buffer for reading text. */
+   unsigned int bufferSize;   /**< Size of the buffer. */
+} TokenArena;
+
+/** Header of a saved token tree.
+ * Tokens are saved in document order, each followed by its
+ * attributes. The strings follow the tokens.
+ */
+typedef struct SavedTreeHeader {
+   unsigned int format;       /**< Identifies the token numbering. */
+   unsigned int count;        /**< Number of top-level tokens. */
+   unsigned int stringOffset; /**< Offset of the strings. */
+} SavedTreeHeader;
+
+/** A saved token. String offsets are 0 for NULL. */
+typedef struct SavedToken {
+   unsigned int type;
+   unsigned int line;
+   unsigned int value;
+   unsigned int invalidName;
+   unsigned int attributeCount;
+   unsigned int childCount;
+} SavedToken;
+
+/** A saved attribute. */
+typedef struct SavedAttribute {
+   unsigned int name;
+   unsigned int value;
+} SavedAttribute;
+
+/** Buffer used when saving a token tree. */
+typedef struct SaveBuffer {
+   char *data;
+   unsigned int length;
+   unsigned int size;
+} SaveBuffer;
+
+/** State used when loading a token tree. */
+typedef struct LoadState {
+   const char *data;          /**< The saved tree. */
+   const char *fileName;      /**< File name for the tokens. */
+   unsigned int position;     /**< Offset of the next token. */
+   unsigned int stringOffset; /**< Offset of the strings. */
+   unsigned int size;         /**< Size of the saved tree. */
+} LoadState;
 
 /** Mapping between token names and tokens.
  * These must be sorted.
@@ -104,19 +179,29 @@ static const StringMappingType TOKEN_MAP[] = {
 static const unsigned int TOKEN_MAP_COUNT = ARRAY_LENGTH(TOKEN_MAP);
 
 static TokenNode *head;
+static TokenArena *arena;
+static unsigned int warningCount;
 
 static TokenNode *CreateNode(TokenNode *current,
                              const char *file,
                              unsigned int line);
 static AttributeNode *CreateAttribute(TokenNode *np); 
 
-static char IsElementEnd(char ch);
-static char IsValueEnd(char ch);
-static char IsAttributeEnd(char ch);
+static void *AllocateToken(size_t size);
+static char *CopyTokenString(const char *str, size_t len);
+static const char *InternString(const char *str);
+static void ReleaseArena(TokenArena *ap);
+static void ReserveBuffer(unsigned int size);
+
+static unsigned int CountLines(const char *start, const char *stop);
+static unsigned int SkipSpace(const char *line, unsigned int x,
+                              unsigned int *lineNumber);
+static unsigned int SkipPast(const char *line, unsigned int x,
+                             const char *str, unsigned int *lineNumber);
 static char *ReadElementName(const char *line);
 static char *ReadValue(const char *line,
                        const char *file,
-                       char (*IsEnd)(char),
+                       char end,
                        unsigned int *offset,
                        unsigned int *lineNumber);
 static char *ReadElementValue(const char *line,
@@ -127,6 +212,18 @@ static char *ReadAttributeValue(const char *line,
                                 const char *file,
                                 unsigned int *offset,
                                 unsigned int *lineNumber);
+static void AppendValue(TokenNode *np, const char *str, size_t len);
+static void LexWarning(const char *str, ...);
+
+static unsigned int GetSaveFormat(void);
+static unsigned int AppendSaved(SaveBuffer *bp, const void *data,
+                                unsigned int len);
+static unsigned int SaveString(SaveBuffer *strings, const char *str);
+static void SaveToken(SaveBuffer *tokens, SaveBuffer *strings,
+                      const TokenNode *np);
+static TokenNode *LoadToken(LoadState *state, TokenNode *parent);
+static char LoadString(const LoadState *state, unsigned int offset,
+                       const char **str);
 static int ParseEntity(const char *entity, char *ch,
                        const char *file, unsigned int line);
 static TokenType LookupType(const char *name, TokenNode *np);
@@ -145,25 +242,21 @@ TokenNode *Tokenize(const char *line, const char *fileName)
    current = NULL;
    inElement = 0;
    lineNumber = 1;
+   warningCount = 0;
+
+   arena = Allocate(sizeof(TokenArena));
+   arena->blocks = NULL;
+   arena->strings = Allocate(sizeof(StringNode*) * STRING_HASH_SIZE);
+   memset(arena->strings, 0, sizeof(StringNode*) * STRING_HASH_SIZE);
+   arena->bufferSize = BUFFER_SIZE;
+   arena->buffer = Allocate(arena->bufferSize);
 
-   x = 0;
    /* Skip any initial white space. */
-   while(IsSpace(line[x], &lineNumber)) {
-      x += 1;
-   }
+   x = SkipSpace(line, 0, &lineNumber);
 
    /* Skip any XML stuff. */
    if(!strncmp(line + x, "<?", 2)) {
-      while(line[x]) {
-         if(line[x] == '\n') {
-            lineNumber += 1;
-         }
-         if(!strncmp(line + x, "?>", 2)) {
-            x += 2;
-            break;
-         }
-         x += 1;
-      }
+      x = SkipPast(line, x, "?>", &lineNumber);
    }
 
    /* Process the XML data. */
@@ -174,22 +267,13 @@ TokenNode *Tokenize(const char *line, const char *fileName)
       do {
 
          /* Skip white space. */
-         while(IsSpace(line[x], &lineNumber)) {
-            x += 1;
-         }
+         x = SkipSpace(line, x, &lineNumber);
 
          /* Skip comments */
          found = 0;
          if(!strncmp(line + x, "<!--", 4)) {
-            while(line[x]) {
-               lineNumber += line[x] == '\n';
-               if(!strncmp(line + x, "-->", 3)) {
-                  x += 3;
-                  found = 1;
-                  break;
-               }
-               x += 1;
-            }
+            x = SkipPast(line, x, "-->", &lineNumber);
+            found = 1;
          }
 
       } while(found);
@@ -205,27 +289,26 @@ TokenNode *Tokenize(const char *line, const char *fileName)
             if(current) {
                if(JLIKELY(temp)) {
                   if(JUNLIKELY(current->type != LookupType(temp, NULL))) {
-                     Warning(_("%s[%u]: close tag \"%s\" does not "
+                     LexWarning(_("%s[%u]: close tag \"%s\" does not "
                              "match open tag \"%s\""),
                              fileName, lineNumber, temp,
                              GetTokenName(current));
                   }
                } else {
-                  Warning(_("%s[%u]: unexpected and invalid close tag"),
+                  LexWarning(_("%s[%u]: unexpected and invalid close tag"),
                           fileName, lineNumber);
                }
                current = current->parent;
             } else {
                if(temp) {
-                  Warning(_("%s[%u]: close tag \"%s\" without open tag"),
+                  LexWarning(_("%s[%u]: close tag \"%s\" without open tag"),
                           fileName, lineNumber, temp);
                } else {
-                  Warning(_("%s[%u]: invalid close tag"), fileName, lineNumber);
+                  LexWarning(_("%s[%u]: invalid close tag"), fileName, lineNumber);
                }
             }
             if(temp) {
                x += strlen(temp);
-               Release(temp);
             }
 
          } else if(current && !strncmp(line + x, "![CDATA[", 8)) {
@@ -235,27 +318,10 @@ TokenNode *Tokenize(const char *line, const char *fileName)
             /* CDATA */
             x += 8;
             start = x;
-            while(line[x]) {
-               lineNumber += line[x] == '\n';
-               if(!strncmp(line + x, "]]>", 3)) {
-                  x += 3;
-                  break;
-               }
-               x += 1;
-            }
+            x = SkipPast(line, x, "]]>", &lineNumber);
             stop = x - 3;
             if(JLIKELY(stop > start)) {
-               const unsigned new_len = stop - start;
-               unsigned value_len = 0;
-               if(current->value) {
-                  value_len = strlen(current->value);
-                  current->value = Reallocate(current->value,
-                                              value_len + new_len + 1);
-               } else {
-                  current->value = Allocate(new_len + 1);
-               }
-               memcpy(&current->value[value_len], &line[start], new_len);
-               current->value[value_len + new_len] = 0;
+               AppendValue(current, &line[start], stop - start);
             }
 
          } else {
@@ -266,9 +332,8 @@ TokenNode *Tokenize(const char *line, const char *fileName)
             if(JLIKELY(temp)) {
                x += strlen(temp);
                LookupType(temp, current);
-               Release(temp);
             } else {
-               Warning(_("%s[%u]: invalid open tag"), fileName, lineNumber);
+               LexWarning(_("%s[%u]: invalid open tag"), fileName, lineNumber);
             }
 
          }
@@ -284,7 +349,7 @@ TokenNode *Tokenize(const char *line, const char *fileName)
                current = current->parent;
                inElement = 0;
             } else {
-               Warning(_("%s[%u]: invalid tag"), fileName, lineNumber);
+               LexWarning(_("%s[%u]: invalid tag"), fileName, lineNumber);
             }
          } else {
             goto ReadDefault;
@@ -305,7 +370,7 @@ ReadDefault:
             /* In the open tag; read attributes. */
             if(current) {
                AttributeNode *ap = CreateAttribute(current);
-               ap->name = ReadElementName(line + x);
+               ap->name = InternString(ReadElementName(line + x));
                if(ap->name) {
                   x += strlen(ap->name);
                   if(line[x] == '=') {
@@ -314,8 +379,9 @@ ReadDefault:
                   if(line[x] == '\"') {
                      x += 1;
                   }
-                  ap->value = ReadAttributeValue(line + x, fileName,
-                                                 &offset, &lineNumber);
+                  ap->value = InternString(
+                     ReadAttributeValue(line + x, fileName,
+                                        &offset, &lineNumber));
                   x += offset;
                   if(line[x] == '\"') {
                      x += 1;
@@ -330,22 +396,10 @@ ReadDefault:
             x += offset;
             if(temp) {
                if(current) {
-                  if(current->value) {
-                     const unsigned value_len = strlen(current->value);
-                     const unsigned temp_len = strlen(temp);
-                     current->value = Reallocate(current->value,
-                                                 value_len + temp_len + 1);
-                     memcpy(&current->value[value_len], temp, temp_len + 1);
-                     Release(temp);
-                  } else {
-                     current->value = temp;
-                  }
-               } else {
-                  if(JUNLIKELY(temp[0])) {
-                     Warning(_("%s[%u]: unexpected text: \"%s\""),
-                             fileName, lineNumber, temp);
-                  }
-                  Release(temp);
+                  AppendValue(current, temp, strlen(temp));
+               } else if(JUNLIKELY(temp[0])) {
+                  LexWarning(_("%s[%u]: unexpected text: \"%s\""),
+                          fileName, lineNumber, temp);
                }
             }
          }
@@ -353,9 +407,111 @@ ReadDefault:
       }
    }
 
+   /* The tree keeps the blocks; the rest is only needed while reading. */
+   Release(arena->strings);
+   Release(arena->buffer);
+   if(head) {
+      head->arena = arena;
+   } else {
+      ReleaseArena(arena);
+   }
+   arena = NULL;
+
    return head;
 }
 
+/** Get the number of warnings from the last call to Tokenize. */
+unsigned int GetTokenizeWarnings(void)
+{
+   return warningCount;
+}
+
+/** Log a warning for the data being tokenized. */
+void LexWarning(const char *str, ...)
+{
+   va_list ap;
+   va_start(ap, str);
+   WarningVA(NULL, str, ap);
+   va_end(ap);
+   warningCount += 1;
+}
+
+/** Append text to the body of a tag. */
+void AppendValue(TokenNode *np, const char *str, size_t len)
+{
+   if(np->value) {
+      const size_t valueLen = strlen(np->value);
+      char *value = AllocateToken(valueLen + len + 1);
+      memcpy(value, np->value, valueLen);
+      memcpy(&value[valueLen], str, len);
+      value[valueLen + len] = 0;
+      np->value = value;
+   } else {
+      np->value = CopyTokenString(str, len);
+   }
+}
+
+/** Allocate memory for the token tree being read. */
+void *AllocateToken(size_t size)
+{
+   TokenBlock *bp = arena->blocks;
+   size_t offset = 0;
+
+   /* Keep allocations aligned for pointers. */
+   if(bp) {
+      offset = (bp->used + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+   }
+   if(!bp || offset + size > bp->size) {
+      const size_t blockSize = Max(size, TOKEN_BLOCK_SIZE);
+      bp = Allocate(sizeof(TokenBlock) + blockSize);
+      bp->size = blockSize;
+      bp->next = arena->blocks;
+      arena->blocks = bp;
+      offset = 0;
+   }
+   bp->used = offset + size;
+   return (char*)(bp + 1) + offset;
+}
+
+/** Copy a string into the token tree being read. */
+char *CopyTokenString(const char *str, size_t len)
+{
+   char *result = AllocateToken(len + 1);
+   memcpy(result, str, len);
+   result[len] = 0;
+   return result;
+}
+
+/** Get the interned copy of a string in the token tree being read. */
+const char *InternString(const char *str)
+{
+   const unsigned int hash = HashString(str) % STRING_HASH_SIZE;
+   StringNode *sp;
+
+   for(sp = arena->strings[hash]; sp; sp = sp->next) {
+      if(!strcmp(sp->str, str)) {
+         return sp->str;
+      }
+   }
+
+   sp = AllocateToken(sizeof(StringNode));
+   sp->str = CopyTokenString(str, strlen(str));
+   sp->next = arena->strings[hash];
+   arena->strings[hash] = sp;
+   return sp->str;
+}
+
+/** Make sure the read buffer can hold size bytes. */
+void ReserveBuffer(unsigned int size)
+{
+   if(JUNLIKELY(size > arena->bufferSize)) {
+      while(size > arena->bufferSize) {
+         arena->bufferSize *= 2;
+      }
+      arena->buffer = Reallocate(arena->buffer, arena->bufferSize);
+   }
+}
+
 /** Parse an entity reference.
  * The entity value is returned in ch and the length of the entity
  * is returned as the value of the function.
@@ -401,7 +557,7 @@ int ParseEntity(const char *entity, char *ch, const char *file,
          temp = AllocateStack(x + 2);
          strncpy(temp, entity, x + 1);
          temp[x + 1] = 0;
-         Warning(_("%s[%d]: invalid entity: \"%.8s\""), file, line, temp);
+         LexWarning(_("%s[%d]: invalid entity: \"%.8s\""), file, line, temp);
          ReleaseStack(temp);
          *ch = '&';
          return 1;
@@ -409,113 +565,102 @@ int ParseEntity(const char *entity, char *ch, const char *file,
    }
 }
 
-/** Determine if ch is the end of a tag/attribute name. */
-char IsElementEnd(char ch)
+/** Count the newlines in a range. */
+unsigned int CountLines(const char *start, const char *stop)
 {
-   switch(ch) {
-   case ' ':
-   case '\t':
-   case '\n':
-   case '\r':
-   case '\"':
-   case '>':
-   case '<':
-   case '/':
-   case '=':
-   case 0:
-      return 1;
-   default:
-      return 0;
+   unsigned int count = 0;
+   while((start = memchr(start, '\n', stop - start)) != NULL) {
+      count += 1;
+      start += 1;
    }
+   return count;
 }
 
-/** Determine if ch is the end of an attribute value. */
-char IsAttributeEnd(char ch)
+/** Skip white space.
+ * @return The offset of the next non-space character.
+ */
+unsigned int SkipSpace(const char *line, unsigned int x,
+                       unsigned int *lineNumber)
 {
-   switch(ch) {
-   case 0:
-   case '\"':
-      return 1;
-   default:
-      return 0;
-   }
+   const unsigned int len = strspn(line + x, " \t\r\n");
+   *lineNumber += CountLines(line + x, line + x + len);
+   return x + len;
 }
 
-/** Determine if ch is the end of tag data. */
-char IsValueEnd(char ch)
+/** Skip past the next occurrence of a string.
+ * @return The offset after the string (or of the end of the data).
+ */
+unsigned int SkipPast(const char *line, unsigned int x,
+                      const char *str, unsigned int *lineNumber)
 {
-   switch(ch) {
-   case 0:
-   case '<':
-      return 1;
-   default:
-      return 0;
+   const char *stop = strstr(line + x, str);
+   if(stop) {
+      stop += strlen(str);
+   } else {
+      stop = line + x + strlen(line + x);
    }
+   *lineNumber += CountLines(line + x, stop);
+   return stop - line;
 }
 
-/** Get the name of the next element. */
+/** Get the name of the next element.
+ * The name is valid until the next read.
+ */
 char *ReadElementName(const char *line)
 {
 
-   char *buffer;
    unsigned int len;
 
    /* Get the length of the element. */
-   for(len = 0; !IsElementEnd(line[len]); len++);
+   len = strcspn(line, " \t\n\r\"></=");
 
-   /* Allocate space for the element. */
-   buffer = Allocate(len + 1);
-   memcpy(buffer, line, len);
-   buffer[len] = 0;
+   ReserveBuffer(len + 1);
+   memcpy(arena->buffer, line, len);
+   arena->buffer[len] = 0;
 
-   return buffer;
+   return arena->buffer;
 
 }
 
-/** Read the value of an element or attribute. */
+/** Read the value of an element or attribute.
+ * Text is copied in runs up to the next end, entity, or newline.
+ * The value is valid until the next read.
+ */
 char *ReadValue(const char *line,
                 const char *file,
-                char (*IsEnd)(char),
+                char end,
                 unsigned int *offset,
                 unsigned int *lineNumber)
 {
-   char *buffer;
+   const char stops[] = { end, '&', '\n', 0 };
    char ch;
-   unsigned int len, max;
+   unsigned int len;
    unsigned int x;
 
    len = 0;
-   max = BLOCK_SIZE;
-   buffer = Allocate(max + 1);
-
-   for(x = 0; !(IsEnd)(line[x]); x++) {
+   x = 0;
+   for(;;) {
+      const unsigned int run = strcspn(line + x, stops);
+      ReserveBuffer(len + run + 2);
+      memcpy(&arena->buffer[len], line + x, run);
+      len += run;
+      x += run;
       if(line[x] == '&') {
-         x += ParseEntity(line + x, &ch, file, *lineNumber) - 1;
-         if(ch) {
-            buffer[len] = ch;
-         } else {
-            buffer[len] = line[x];
-         }
+         x += ParseEntity(line + x, &ch, file, *lineNumber);
+         arena->buffer[len++] = ch ? ch : line[x - 1];
+      } else if(line[x] == '\n') {
+         *lineNumber += 1;
+         arena->buffer[len++] = '\n';
+         x += 1;
       } else {
-         if(line[x] == '\n') {
-            *lineNumber += 1;
-         }
-         buffer[len] = line[x];
-      }
-      len += 1;
-      if(len >= max) {
-         max += BLOCK_SIZE;
-         buffer = Reallocate(buffer, max + 1);
-         if(JUNLIKELY(buffer == NULL)) {
-            FatalError(_("out of memory"));
-         }
+         break;
       }
    }
-   buffer[len] = 0;
-   Trim(buffer);
+   arena->buffer[len] = 0;
+   Trim(arena->buffer);
    *offset = x;
 
-   return buffer;
+   return arena->buffer;
 }
 
 /** Get the value of the current element. */
@@ -524,7 +669,7 @@ char *ReadElementValue(const char *line,
                        unsigned int *offset,
                        unsigned int *lineNumber)
 {
-   return ReadValue(line, file, IsValueEnd, offset, lineNumber);
+   return ReadValue(line, file, '<', offset, lineNumber);
 }
 
 /** Get the value of the current attribute. */
@@ -533,7 +678,7 @@ char *ReadAttributeValue(const char *line,
                          unsigned int *offset,
                          unsigned int *lineNumber)
 {
-   return ReadValue(line, file, IsAttributeEnd, offset, lineNumber);
+   return ReadValue(line, file, '\"', offset, lineNumber);
 }
 
 /** Get the token for a tag name. */
@@ -549,7 +694,7 @@ TokenType LookupType(const char *name, TokenNode *np)
 
    if(JUNLIKELY(np)) {
       np->type = TOK_INVALID;
-      np->invalidName = CopyString(name);
+      np->invalidName = CopyTokenString(name, strlen(name));
    }
 
    return TOK_INVALID;
@@ -578,7 +723,8 @@ TokenNode *CreateNode(TokenNode *current, const char *file,
 {
    TokenNode *np;
 
-   np = Allocate(sizeof(TokenNode));
+   np = AllocateToken(sizeof(TokenNode));
+   np->arena = NULL;
    np->type = TOK_INVALID;
    np->value = NULL;
    np->attributes = NULL;
@@ -610,8 +756,8 @@ TokenNode *CreateNode(TokenNode *current, const char *file,
 
       /* A duplicate top-level node.
        * This is probably a configuration error.
+       * The node is released with the rest of the tree.
        */
-      ReleaseTokens(np);
       np = head->subnodeTail ? head->subnodeTail : head;
 
    }
@@ -623,7 +769,7 @@ TokenNode *CreateNode(TokenNode *current, const char *file,
 AttributeNode *CreateAttribute(TokenNode *np)
 {
    AttributeNode *ap;
-   ap = Allocate(sizeof(AttributeNode));
+   ap = AllocateToken(sizeof(AttributeNode));
    ap->name = NULL;
    ap->value = NULL;
    ap->next = np->attributes;
@@ -631,42 +777,273 @@ AttributeNode *CreateAttribute(TokenNode *np)
    return ap;
 }
 
-/** Release a token list. */
+/** Release a token list.
+ * The whole tree is released with its top-level token.
+ */
 void ReleaseTokens(TokenNode *np)
 {
+   if(np && np->arena) {
+      ReleaseArena(np->arena);
+   }
+}
 
-   AttributeNode *ap;
-   TokenNode *tp;
+/** Release the memory of a token tree. */
+void ReleaseArena(TokenArena *ap)
+{
+   while(ap->blocks) {
+      TokenBlock *next = ap->blocks->next;
+      Release(ap->blocks);
+      ap->blocks = next;
+   }
+   Release(ap);
+}
 
-   while(np) {
-      tp = np->next;
+/** Get a value identifying the token numbering.
+ * Saved trees are only valid for the same token map.
+ */
+unsigned int GetSaveFormat(void)
+{
+   unsigned int hash = sizeof(SavedToken);
+   unsigned int x;
+   for(x = 0; x < TOKEN_MAP_COUNT; x++) {
+      hash = hash * 31 + HashString(TOKEN_MAP[x].key);
+      hash = hash * 31 + (unsigned int)TOKEN_MAP[x].value;
+   }
+   return hash;
+}
 
-      while(np->attributes) {
-         ap = np->attributes->next;
-         if(np->attributes->name) {
-            Release(np->attributes->name);
-         }
-         if(np->attributes->value) {
-            Release(np->attributes->value);
-         }
-         Release(np->attributes);
-         np->attributes = ap;
+/** Append data to a save buffer.
+ * @return The offset of the data in the buffer.
+ */
+unsigned int AppendSaved(SaveBuffer *bp, const void *data, unsigned int len)
+{
+   const unsigned int offset = bp->length;
+   if(bp->length + len > bp->size) {
+      while(bp->length + len > bp->size) {
+         bp->size *= 2;
       }
+      bp->data = Reallocate(bp->data, bp->size);
+   }
+   memcpy(&bp->data[offset], data, len);
+   bp->length += len;
+   return offset;
+}
 
-      if(np->subnodeHead) {
-         ReleaseTokens(np->subnodeHead);
+/** Save a string, returning its offset (0 for NULL). */
+unsigned int SaveString(SaveBuffer *strings, const char *str)
+{
+   if(str) {
+      return AppendSaved(strings, str, strlen(str) + 1);
+   } else {
+      return 0;
+   }
+}
+
+/** Save a token, its attributes, and its children. */
+void SaveToken(SaveBuffer *tokens, SaveBuffer *strings,
+               const TokenNode *np)
+{
+   SavedToken token;
+   const AttributeNode *ap;
+   const TokenNode *child;
+
+   token.type = np->type;
+   token.line = np->line;
+   token.value = SaveString(strings, np->value);
+   token.invalidName = SaveString(strings, np->invalidName);
+   token.attributeCount = 0;
+   for(ap = np->attributes; ap; ap = ap->next) {
+      token.attributeCount += 1;
+   }
+   token.childCount = 0;
+   for(child = np->subnodeHead; child; child = child->next) {
+      token.childCount += 1;
+   }
+   AppendSaved(tokens, &token, sizeof(token));
+
+   for(ap = np->attributes; ap; ap = ap->next) {
+      SavedAttribute attr;
+      attr.name = SaveString(strings, ap->name);
+      attr.value = SaveString(strings, ap->value);
+      AppendSaved(tokens, &attr, sizeof(attr));
+   }
+   for(child = np->subnodeHead; child; child = child->next) {
+      SaveToken(tokens, strings, child);
+   }
+}
+
+/** Save a token tree. */
+char *SaveTokens(const TokenNode *np, unsigned int *size)
+{
+   SavedTreeHeader header;
+   SaveBuffer tokens;
+   SaveBuffer strings;
+   const TokenNode *tp;
+
+   tokens.size = BUFFER_SIZE;
+   tokens.length = 0;
+   tokens.data = Allocate(tokens.size);
+   strings.size = BUFFER_SIZE;
+   strings.length = 0;
+   strings.data = Allocate(strings.size);
+
+   /* Offset 0 is reserved for NULL. */
+   AppendSaved(&strings, "", 1);
+
+   memset(&header, 0, sizeof(header));
+   AppendSaved(&tokens, &header, sizeof(header));
+   for(tp = np; tp; tp = tp->next) {
+      SaveToken(&tokens, &strings, tp);
+      header.count += 1;
+   }
+   header.format = GetSaveFormat();
+   header.stringOffset = tokens.length;
+   memcpy(tokens.data, &header, sizeof(header));
+
+   AppendSaved(&tokens, strings.data, strings.length);
+   Release(strings.data);
+
+   *size = tokens.length;
+   return tokens.data;
+}
+
+/** Look up a string in a saved tree.
+ * @return 1 on success, 0 if the offset is invalid.
+ */
+char LoadString(const LoadState *state, unsigned int offset,
+                const char **str)
+{
+   if(offset == 0) {
+      *str = NULL;
+      return 1;
+   } else if(offset < state->size - state->stringOffset) {
+      *str = state->data + state->stringOffset + offset;
+      return 1;
+   } else {
+      return 0;
+   }
+}
+
+/** Load a token, its attributes, and its children.
+ * @return The token or NULL if the data is invalid.
+ */
+TokenNode *LoadToken(LoadState *state, TokenNode *parent)
+{
+   SavedToken token;
+   TokenNode *np;
+   AttributeNode **lastAttribute;
+   unsigned int x;
+
+   if(state->position + sizeof(token) > state->stringOffset) {
+      return NULL;
+   }
+   memcpy(&token, state->data + state->position, sizeof(token));
+   state->position += sizeof(token);
+
+   np = AllocateToken(sizeof(TokenNode));
+   np->arena = NULL;
+   np->type = token.type;
+   np->line = token.line;
+   np->fileName = state->fileName;
+   np->attributes = NULL;
+   np->subnodeHead = NULL;
+   np->subnodeTail = NULL;
+   np->parent = parent;
+   np->next = NULL;
+   if(!LoadString(state, token.value, &np->value)
+      || !LoadString(state, token.invalidName, &np->invalidName)) {
+      return NULL;
+   }
+
+   /* Keep the attributes in their saved order. */
+   lastAttribute = &np->attributes;
+   for(x = 0; x < token.attributeCount; x++) {
+      SavedAttribute attr;
+      AttributeNode *ap;
+      if(state->position + sizeof(attr) > state->stringOffset) {
+         return NULL;
       }
+      memcpy(&attr, state->data + state->position, sizeof(attr));
+      state->position += sizeof(attr);
+      ap = AllocateToken(sizeof(AttributeNode));
+      ap->next = NULL;
+      if(!LoadString(state, attr.name, &ap->name)
+         || !LoadString(state, attr.value, &ap->value)) {
+         return NULL;
+      }
+      *lastAttribute = ap;
+      lastAttribute = &ap->next;
+   }
 
-      if(np->value) {
-         Release(np->value);
+   for(x = 0; x < token.childCount; x++) {
+      TokenNode *child = LoadToken(state, np);
+      if(!child) {
+         return NULL;
       }
+      if(np->subnodeTail) {
+         np->subnodeTail->next = child;
+      } else {
+         np->subnodeHead = child;
+      }
+      np->subnodeTail = child;
+   }
+
+   return np;
+}
 
-      if(np->invalidName) {
-         Release(np->invalidName);
+/** Load a saved token tree. */
+TokenNode *LoadTokens(const char *data, unsigned int size,
+                      const char *fileName)
+{
+   SavedTreeHeader header;
+   LoadState state;
+   TokenNode *last;
+   unsigned int x;
+
+   if(size < sizeof(header) + 1 || data[size - 1] != 0) {
+      return NULL;
+   }
+   memcpy(&header, data, sizeof(header));
+   if(header.format != GetSaveFormat()
+      || header.stringOffset < sizeof(header)
+      || header.stringOffset >= size) {
+      return NULL;
+   }
+
+   state.data = data;
+   state.fileName = fileName;
+   state.position = sizeof(header);
+   state.stringOffset = header.stringOffset;
+   state.size = size;
+
+   arena = Allocate(sizeof(TokenArena));
+   arena->blocks = NULL;
+   arena->strings = NULL;
+   arena->buffer = NULL;
+   arena->bufferSize = 0;
+
+   head = NULL;
+   last = NULL;
+   for(x = 0; x < header.count; x++) {
+      TokenNode *np = LoadToken(&state, NULL);
+      if(JUNLIKELY(!np)) {
+         head = NULL;
+         break;
       }
+      if(last) {
+         last->next = np;
+      } else {
+         head = np;
+      }
+      last = np;
+   }
 
-      Release(np);
-      np = tp;
+   if(head) {
+      head->arena = arena;
+   } else {
+      ReleaseArena(arena);
    }
+   arena = NULL;
 
+   return head;
 }
@@ -102,8 +102,8 @@ typedef enum {
 /** Structure to represent an XML attribute. */
 typedef struct AttributeNode {
 
-   char *name;                  /**< The name of the attribute. */
-   char *value;                 /**< The value for the attribute. */
+   const char *name;            /**< The name of the attribute. */
+   const char *value;           /**< The value for the attribute. */
    struct AttributeNode *next;  /**< The next attribute in the list. */
 
 } AttributeNode;
@@ -112,8 +112,8 @@ typedef struct AttributeNode {
 typedef struct TokenNode {
 
    TokenType type;            /**< Tag type. */
-   char *invalidName;         /**< Name of the tag if invalid. */
-   char *value;               /**< Body of the tag. */
+   const char *invalidName;   /**< Name of the tag if invalid. */
+   const char *value;         /**< Body of the tag. */
    const char *fileName;      /**< Name of the file containing this tag. */
    unsigned int line;         /**< Line number of the start of this tag. */
    struct AttributeNode *attributes;   /**< Linked list of attributes. */
@@ -121,6 +121,7 @@ typedef struct TokenNode {
    struct TokenNode *subnodeHead;      /**< Start of children. */
    struct TokenNode *subnodeTail;      /**< End of children. */
    struct TokenNode *next;             /**< Next tag at the current level. */
+   struct TokenArena *arena;  /**< Memory for the tree (top-level only). */
 
 } TokenNode;
 
@@ -131,6 +132,31 @@ typedef struct TokenNode {
  */
 TokenNode *Tokenize(const char *line, const char *fileName);
 
+/** Get the number of warnings from the last call to Tokenize.
+ * @return The number of warnings.
+ */
+unsigned int GetTokenizeWarnings(void);
+
+/** Save a token tree to a buffer.
+ * The buffer does not depend on its address and can be loaded with
+ * LoadTokens in a later session.
+ * @param np The top-level token.
+ * @param size Set to the size of the buffer.
+ * @return The buffer (to be released with Release).
+ */
+char *SaveTokens(const TokenNode *np, unsigned int *size);
+
+/** Load a token tree saved with SaveTokens.
+ * The strings of the tokens point into the data, so the data must
+ * remain valid until the tokens are released.
+ * @param data The saved tree.
+ * @param size The size of the saved tree.
+ * @param fileName The name of the file for error reporting.
+ * @return The tokens (NULL if the data is invalid).
+ */
+TokenNode *LoadTokens(const char *data, unsigned int size,
+                      const char *fileName);
+
 /** Get a string represention of a token.
  * This is identical to GetTokenTypeName if tp is a valid token.
  * @param tp The token node.
@@ -145,6 +171,7 @@ const char *GetTokenName(const TokenNode *tp);
 const char *GetTokenTypeName(TokenType type);
 
 /** Release token nodes.
+ * All tokens from the same call to Tokenize are released together.
  * @param np The top-level token to release.
  */
 void ReleaseTokens(TokenNode *np);
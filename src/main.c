@@ -24,6 +24,8 @@
 #include "group.h"
 #include "binding.h"
 #include "icon.h"
+#include "imagecache.h"
+#include "configcache.h"
 #include "taskbar.h"
 #include "tray.h"
 #include "traybutton.h"
@@ -41,6 +43,7 @@
 #include "settings.h"
 #include "timing.h"
 #include "grab.h"
+#include "winmap.h"
 
 #include <errno.h>
 
@@ -67,9 +70,6 @@ unsigned int previousDesktop = 0;
 
 char *exitCommand = NULL;
 
-XContext clientContext;
-XContext frameContext;
-
 #ifdef USE_SHAPE
 char haveShape;
 int shapeEvent;
@@ -77,6 +77,10 @@ int shapeEvent;
 #ifdef USE_XRENDER
 char haveRender;
 #endif
+#ifdef USE_XCOMPOSITE
+char haveComposite;
+int damageEvent;
+#endif
 
 static void Initialize(void);
 static void Startup(void);
@@ -111,7 +115,9 @@ int main(int argc, char *argv[])
       COMMAND_RESTART,
       COMMAND_EXIT,
       COMMAND_RELOAD,
-      COMMAND_PARSE
+      COMMAND_PARSE,
+      COMMAND_PRUNECACHE,
+      COMMAND_CLEARCACHE
    } action;
 
    StartDebug();
@@ -133,6 +139,10 @@ int main(int argc, char *argv[])
          action = COMMAND_EXIT;
       } else if(!strcmp(argv[x], "-reload")) {
          action = COMMAND_RELOAD;
+      } else if(!strcmp(argv[x], "-prunecache")) {
+         action = COMMAND_PRUNECACHE;
+      } else if(!strcmp(argv[x], "-clearcache")) {
+         action = COMMAND_CLEARCACHE;
       } else if(!strcmp(argv[x], "-display") && x + 1 < argc) {
          displayString = argv[++x];
       } else if(!strcmp(argv[x], "-f") && x + 1 < argc) {
@@ -150,7 +160,7 @@ int main(int argc, char *argv[])
    switch(action) {
    case COMMAND_PARSE:
       Initialize();
-      ParseConfig(configPath);
+      ParseConfig(configPath, CONFIG_ALL);
       DoExit(0);
    case COMMAND_RESTART:
       SendRestart();
@@ -161,6 +171,13 @@ int main(int argc, char *argv[])
    case COMMAND_RELOAD:
       SendReload();
       DoExit(0);
+   case COMMAND_PRUNECACHE:
+      PruneImageCache();
+      DoExit(0);
+   case COMMAND_CLEARCACHE:
+      ClearImageCache();
+      ClearConfigCache();
+      DoExit(0);
    default:
       break;
    }
@@ -186,7 +203,7 @@ int main(int argc, char *argv[])
       Initialize();
 
       /* Parse the configuration file. */
-      ParseConfig(configPath);
+      ParseConfig(configPath, CONFIG_ALL);
 
       /* Start up the JWM components. */
       Startup();
@@ -321,6 +338,11 @@ void StartupConnection(void)
 #ifdef USE_XRENDER
    int renderEvent;
    int renderError;
+#endif
+#ifdef USE_XCOMPOSITE
+   int compositeEvent, compositeError;
+   int damageError;
+   int major, minor;
 #endif
    struct sigaction sa;
    char name[32];
@@ -376,9 +398,6 @@ void StartupConnection(void)
 
    JXSetErrorHandler(ErrorHandler);
 
-   clientContext = XUniqueContext();
-   frameContext = XUniqueContext();
-
    /* Set the events we want for the root window.
     * Note that asking for SubstructureRedirect will fail
     * if another window manager is already running.
@@ -422,6 +441,24 @@ void StartupConnection(void)
    }
 #endif
 
+#ifdef USE_XCOMPOSITE
+   /* Named window pixmaps need composite 0.2. */
+   haveComposite = 0;
+   if(haveRender
+      && JXCompositeQueryExtension(display, &compositeEvent, &compositeError)
+      && JXDamageQueryExtension(display, &damageEvent, &damageError)) {
+      major = 0;
+      minor = 0;
+      JXCompositeQueryVersion(display, &major, &minor);
+      haveComposite = major > 0 || minor >= 2;
+   }
+   if(haveComposite) {
+      Debug("composite extension enabled");
+   } else {
+      Debug("composite extension disabled");
+   }
+#endif
+
    /* Make sure we have input focus. */
    win = None;
    JXGetInputFocus(display, &win, &revert);
@@ -479,10 +516,12 @@ void Initialize(void)
    InitializeDialogs();
 #endif
    InitializeDock();
+   InitializeEvents();
    InitializeFonts();
    InitializeGroups();
    InitializeHints();
    InitializeIcons();
+   InitializeImageCache();
    InitializePager();
    InitializePlacement();
    InitializePopup();
@@ -493,6 +532,7 @@ void Initialize(void)
    InitializeTaskBar();
    InitializeTray();
    InitializeTrayButtons();
+   InitializeWindowMap();
 }
 
 /** Startup the various JWM components.
@@ -507,12 +547,15 @@ void Startup(void)
     * while we're still loading. */
    GrabServer();
 
+   StartupWindowMap();
+   StartupEvents();
    StartupSettings();
    StartupScreens();
 
    StartupGroups();
    StartupColors();
    StartupFonts();
+   StartupImageCache();
    StartupIcons();
    StartupBackgrounds();
    StartupCursors();
@@ -588,6 +631,7 @@ void Shutdown(void)
    ShutdownClients();
    ShutdownBackgrounds();
    ShutdownIcons();
+   ShutdownImageCache();
    ShutdownCursors();
    ShutdownFonts();
    ShutdownColors();
@@ -600,6 +644,8 @@ void Shutdown(void)
    ShutdownSettings();
 
    ShutdownCommands();
+   ShutdownEvents();
+   ShutdownWindowMap();
 
 }
 
@@ -621,10 +667,12 @@ void Destroy(void)
    DestroyDialogs();
 #endif
    DestroyDock();
+   DestroyEvents();
    DestroyFonts();
    DestroyGroups();
    DestroyHints();
    DestroyIcons();
+   DestroyImageCache();
    DestroyBindings();
    DestroyPager();
    DestroyPlacement();
@@ -636,6 +684,7 @@ void Destroy(void)
    DestroyTaskBar();
    DestroyTray();
    DestroyTrayButtons();
+   DestroyWindowMap();
 }
 
 /** Send _JWM_RESTART to the root window. */
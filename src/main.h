@@ -33,9 +33,6 @@ extern char isRestarting;
 extern char shouldReload;
 extern char initializing;
 
-extern XContext clientContext;
-extern XContext frameContext;
-
 #ifdef USE_SHAPE
 extern char haveShape;
 extern int shapeEvent;
@@ -43,6 +40,10 @@ extern int shapeEvent;
 #ifdef USE_XRENDER
 extern char haveRender;
 #endif
+#ifdef USE_XCOMPOSITE
+extern char haveComposite;
+extern int damageEvent;
+#endif
 
 extern char *configPath;
 
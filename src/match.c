@@ -9,32 +9,77 @@
 
 #include "jwm.h"
 #include "match.h"
+#include "misc.h"
 
-#include <regex.h>
+static char IsLiteral(const char *str, size_t len);
 
-/** Determine if expression matches pattern. */
-char Match(const char *pattern, const char *expression)
+/** Determine if a string contains no regular expression operators. */
+char IsLiteral(const char *str, size_t len)
+{
+   size_t i;
+   for(i = 0; i < len; i++) {
+      if(strchr(".[]()*+?{}|^$\\", str[i])) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/** Compile a pattern. */
+char CompilePattern(PatternType *pp, const char *expression)
 {
 
-   regex_t re;
-   regmatch_t rm;
-   int rc;
+   const size_t len = strlen(expression);
 
-   if(!pattern && !expression) {
+   Assert(pp);
+   Assert(expression);
+
+   if(len >= 2 && expression[0] == '^' && expression[len - 1] == '$'
+      && IsLiteral(&expression[1], len - 2)) {
+      pp->text = Allocate(len - 1);
+      memcpy(pp->text, &expression[1], len - 2);
+      pp->text[len - 2] = 0;
+      pp->kind = PATTERN_EXACT;
       return 1;
-   } else if(!pattern || !expression) {
-      return 0;
    }
 
-   if(regcomp(&re, pattern, REG_EXTENDED) != 0) {
+   pp->text = CopyString(expression);
+   if(IsLiteral(expression, len)) {
+      pp->kind = PATTERN_LITERAL;
+   } else if(regcomp(&pp->re, expression, REG_EXTENDED | REG_NOSUB) == 0) {
+      pp->kind = PATTERN_REGEX;
+   } else {
+      pp->kind = PATTERN_INVALID;
       return 0;
    }
+   return 1;
 
-   rc = regexec(&re, expression, 0, &rm, 0);
-
-   regfree(&re);
+}
 
-   return rc == 0 ? 1 : 0;
+/** Release a compiled pattern. */
+void ReleasePattern(PatternType *pp)
+{
+   if(pp->kind == PATTERN_REGEX) {
+      regfree(&pp->re);
+   }
+   Release(pp->text);
+}
 
+/** Check if a string matches a compiled pattern. */
+char MatchPattern(const PatternType *pp, const char *str)
+{
+   if(!str) {
+      return 0;
+   }
+   switch(pp->kind) {
+   case PATTERN_EXACT:
+      return !strcmp(pp->text, str);
+   case PATTERN_LITERAL:
+      return strstr(str, pp->text) != NULL;
+   case PATTERN_REGEX:
+      return regexec(&pp->re, str, 0, NULL, 0) == 0;
+   default:
+      return 0;
+   }
 }
 
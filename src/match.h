@@ -10,12 +10,41 @@
 #ifndef MATCH_H
 #define MATCH_H
 
-/** Check if an expression matches a pattern.
- * @param pattern The pattern to match against.
- * @param expression The expression to check.
+#include <regex.h>
+
+/** Enumeration of pattern kinds. */
+typedef unsigned char PatternKind;
+#define PATTERN_INVALID 0  /**< Invalid expression (never matches). */
+#define PATTERN_EXACT   1  /**< Anchored literal ("^text$"). */
+#define PATTERN_LITERAL 2  /**< Unanchored literal ("text"). */
+#define PATTERN_REGEX   3  /**< Any other regular expression. */
+
+/** A compiled pattern. */
+typedef struct PatternType {
+   char *text;          /**< The literal text or the expression. */
+   regex_t re;          /**< The compiled expression (PATTERN_REGEX). */
+   PatternKind kind;    /**< The kind of pattern. */
+} PatternType;
+
+/** Compile a pattern.
+ * Patterns that are plain strings are not passed to regcomp.
+ * @param pp The pattern to initialize.
+ * @param expression The extended regular expression.
+ * @return 1 on success, 0 if the expression is invalid.
+ */
+char CompilePattern(PatternType *pp, const char *expression);
+
+/** Release a compiled pattern.
+ * @param pp The pattern to release (the structure itself is not freed).
+ */
+void ReleasePattern(PatternType *pp);
+
+/** Check if a string matches a compiled pattern.
+ * @param pp The pattern.
+ * @param str The string to check (may be NULL).
  * @return 1 if there is a match, 0 otherwise.
  */
-char Match(const char *pattern, const char *expression);
+char MatchPattern(const PatternType *pp, const char *str);
 
 #endif /* MATCH_H */
 
@@ -25,9 +25,32 @@
 #include "hint.h"
 #include "misc.h"
 #include "popup.h"
+#include "winmap.h"
 
 #define BASE_ICON_OFFSET   3
 #define MENU_BORDER_SIZE   1
+#define MENU_SEARCH_SIZE   64
+
+/** State of a type-to-filter search.
+ * Only the innermost open menu can be filtered, so one search is
+ * active at a time. While searching, the item list of the menu is
+ * replaced by the matching items from its submenu tree.
+ */
+typedef struct MenuSearchType {
+   Menu *menu;                   /**< The filtered menu (or NULL). */
+   char *label;                  /**< The original menu label. */
+   MenuItem **itemList;          /**< The original items. */
+   int *offsets;                 /**< The original item offsets. */
+   unsigned int itemCount;       /**< The original number of items. */
+   int height;                   /**< The original menu height. */
+   MenuItem **results;           /**< Matching items. */
+   const char **resultKeys;      /**< Search keys of the matching items. */
+   int *resultOffsets;           /**< y-offsets of the matching items. */
+   unsigned int resultCount;     /**< Number of matching items. */
+   unsigned int resultMax;       /**< Allocated size of the results. */
+   unsigned int length;          /**< Length of the search text. */
+   char text[MENU_SEARCH_SIZE];  /**< The search text (lowercase). */
+} MenuSearchType;
 
 typedef unsigned char MenuSelectionType;
 #define MENU_NOSELECTION   0
@@ -52,7 +75,11 @@ static MenuSelectionType UpdateMotion(Menu *menu,
                                       XEvent *event);
 
 static void UpdateMenu(Menu *menu);
+static void DrawMenuBorder(Menu *menu);
 static void DrawMenuItem(Menu *menu, MenuItem *item, int index);
+static void CopyMenuItem(Menu *menu, int index);
+static int GetMenuItemHeight(const Menu *menu, int index);
+static char ScrollMenu(Menu *menu, int index);
 static MenuItem *GetMenuItem(Menu *menu, int index);
 static int GetNextMenuIndex(Menu *menu);
 static int GetPreviousMenuIndex(Menu *menu);
@@ -60,6 +87,17 @@ static int GetMenuIndex(Menu *menu, int index);
 static void SetPosition(Menu *tp, int index);
 static char IsMenuValid(const Menu *menu);
 
+static char *CreateSearchKey(const char *name);
+static void UpdateSearch(Menu *menu, XKeyEvent *event);
+static void SearchMenu(const Menu *menu);
+static void NarrowSearch(void);
+static void AddSearchResult(MenuItem *item, const char *key);
+static void ShowSearchResults(void);
+static void EndSearch(Menu *menu);
+static void ResizeMenuWindow(Menu *menu);
+
+static MenuSearchType search;
+
 int menuShown = 0;
 
 /** Allocate an empty menu. */
@@ -71,6 +109,9 @@ Menu *CreateMenu()
    menu->label = NULL;
    menu->dynamic = NULL;
    menu->timeout_ms = MENU_TIMEOUT_MS;
+   menu->offsets = NULL;
+   menu->itemList = NULL;
+   menu->keys = NULL;
    return menu;
 }
 
@@ -83,6 +124,13 @@ MenuItem *CreateMenuItem(MenuItemType type)
    return item;
 }
 
+/** Get the size of client icons in menus with the default item height. */
+int GetMenuIconSize(void)
+{
+   return GetStringHeight(FONT_MENU) + BASE_ICON_OFFSET * 2
+        - BUTTON_BORDER * 2;
+}
+
 /** Initialize a menu. */
 void InitializeMenu(Menu *menu)
 {
@@ -119,6 +167,7 @@ void InitializeMenu(Menu *menu)
    if(userHeight) {
       menu->itemHeight = userHeight + BASE_ICON_OFFSET * 2;
    }
+   RequestIconSize(menu->itemHeight - BUTTON_BORDER * 2);
    if(hasIcon) {
       menu->textOffset = menu->itemHeight + BASE_ICON_OFFSET * 2;
    }
@@ -139,6 +188,8 @@ void InitializeMenu(Menu *menu)
    if(menu->label) {
       menu->height += menu->itemHeight;
    }
+   menu->viewHeight = menu->height;
+   menu->scrollOffset = 0;
 
    /* Nothing else to do if there is nothing in the menu. */
    if(JUNLIKELY(menu->itemCount == 0)) {
@@ -146,10 +197,14 @@ void InitializeMenu(Menu *menu)
    }
 
    menu->offsets = Allocate(sizeof(int) * menu->itemCount);
+   menu->itemList = Allocate(sizeof(MenuItem*) * menu->itemCount);
+   menu->keys = Allocate(sizeof(char*) * menu->itemCount);
 
    hasSubmenu = 0;
    index = 0;
    for(np = menu->items; np; np = np->next) {
+      menu->itemList[index] = np;
+      menu->keys[index] = CreateSearchKey(np->name);
       menu->offsets[index++] = menu->height;
       if(np->type == MENU_ITEM_SEPARATOR) {
          menu->height += 6;
@@ -173,6 +228,7 @@ void InitializeMenu(Menu *menu)
    menu->width += hasSubmenu + menu->textOffset;
    menu->width += 7 + 2 * MENU_BORDER_SIZE;
    menu->height += MENU_BORDER_SIZE;
+   menu->viewHeight = menu->height;
    menu->mousex = -1;
    menu->mousey = -1;
 
@@ -220,7 +276,7 @@ char ShowMenu(Menu *menu, RunMenuCommandType runner,
    RefocusClient();
 
    if(shouldReload) {
-      ReloadMenu();
+      ReloadConfig();
    }
 
    return 1;
@@ -277,6 +333,18 @@ void DestroyMenu(Menu *menu)
       if(menu->offsets) {
          Release(menu->offsets);
       }
+      if(menu->itemList) {
+         Release(menu->itemList);
+      }
+      if(menu->keys) {
+         unsigned int i;
+         for(i = 0; i < menu->itemCount; i++) {
+            if(menu->keys[i]) {
+               Release(menu->keys[i]);
+            }
+         }
+         Release(menu->keys);
+      }
       Release(menu);
    }
 }
@@ -296,7 +364,9 @@ char ShowSubmenu(Menu *menu, Menu *parent,
    menuShown += 1;
    status = MenuLoop(menu, runner);
    menuShown -= 1;
+   EndSearch(menu);
 
+   UnregisterWindow(menu->window);
    JXDestroyWindow(display, menu->window);
    JXFreePixmap(display, menu->pixmap);
 
@@ -449,13 +519,13 @@ char MenuLoop(Menu *menu, RunMenuCommandType runner)
                if(event.xbutton.x >= menu->x &&
                   event.xbutton.x < menu->x + menu->width &&
                   event.xbutton.y >= menu->y &&
-                  event.xbutton.y < menu->y + menu->height) {
+                  event.xbutton.y < menu->y + menu->viewHeight) {
                   break;
                } else if(parent &&
                          event.xbutton.x >= parent->x &&
                          event.xbutton.x < parent->x + parent->width &&
                          event.xbutton.y >= parent->y &&
-                         event.xbutton.y < parent->y + parent->height) {
+                         event.xbutton.y < parent->y + parent->viewHeight) {
                   break;
                }
             }
@@ -473,7 +543,6 @@ void MenuCallback(const TimeType *now, int x, int y, Window w, void *data)
 {
    Menu *menu = data;
    MenuItem *item;
-   int i;
 
    /* Check if the mouse moved (and reset if it did). */
    if(   abs(menu->mousex - x) > settings.doubleClickDelta
@@ -493,17 +562,14 @@ void MenuCallback(const TimeType *now, int x, int y, Window w, void *data)
    /* Locate the active menu item. */
    while(menu) {
       if(x > menu->x && x < menu->x + menu->width) {
-         if(y > menu->y && y < menu->y + menu->height) {
+         if(y > menu->y && y < menu->y + menu->viewHeight) {
             break;
          }
       }
       if(menu->currentIndex < 0) {
          return;
       }
-      item = menu->items;
-      for(i = 0; i < menu->currentIndex; i++) {
-         item = item->next;
-      }
+      item = GetMenuItem(menu, menu->currentIndex);
       if(item->type != MENU_ITEM_SUBMENU) {
          return;
       }
@@ -515,10 +581,7 @@ void MenuCallback(const TimeType *now, int x, int y, Window w, void *data)
    if(menu->currentIndex < 0) {
       return;
    }
-   item = menu->items;
-   for(i = 0; i < menu->currentIndex; i++) {
-      item = item->next;
-   }
+   item = GetMenuItem(menu, menu->currentIndex);
    if(item->tooltip) {
       ShowPopup(x, y, item->tooltip, POPUP_MENU);
    }
@@ -544,9 +607,13 @@ void MapMenu(Menu *menu, int x, int y, char keyboard)
          x = menu->screen->x + menu->screen->width - menu->width;
       }
    }
+   /* Menus taller than the screen are scrolled within the window. */
+   menu->viewHeight = Min(menu->height, menu->screen->height);
+   menu->scrollOffset = 0;
+
    temp = y;
-   if(y + menu->height > menu->screen->y + menu->screen->height) {
-      y = menu->screen->y + menu->screen->height - menu->height;
+   if(y + menu->viewHeight > menu->screen->y + menu->screen->height) {
+      y = menu->screen->y + menu->screen->height - menu->viewHeight;
    }
    if(y < 0) {
       y = 0;
@@ -568,13 +635,14 @@ void MapMenu(Menu *menu, int x, int y, char keyboard)
    attr.save_under = True;
 
    menu->window = JXCreateWindow(display, rootWindow, x, y,
-                                 menu->width, menu->height, 0,
+                                 menu->width, menu->viewHeight, 0,
                                  CopyFromParent, InputOutput,
                                  CopyFromParent, attrMask, &attr);
    SetAtomAtom(menu->window, ATOM_NET_WM_WINDOW_TYPE,
                ATOM_NET_WM_WINDOW_TYPE_MENU);
+   RegisterWindow(menu->window, OWNER_MENU, menu);
    menu->pixmap = JXCreatePixmap(display, menu->window,
-                                 menu->width, menu->height, rootDepth);
+                                 menu->width, menu->viewHeight, rootDepth);
 
    if(settings.menuOpacity < UINT_MAX) {
       SetCardinalAtom(menu->window, ATOM_NET_WM_WINDOW_OPACITY,
@@ -595,47 +663,59 @@ void MapMenu(Menu *menu, int x, int y, char keyboard)
 
 }
 
-/** Draw a menu. */
+/** Draw a menu.
+ * Only the items visible in the menu window are rendered.
+ */
 void DrawMenu(Menu *menu)
 {
 
-   MenuItem *np;
-   int x;
+   int index;
 
    JXSetForeground(display, rootGC, colors[COLOR_MENU_BG]);
    JXFillRectangle(display, menu->pixmap, rootGC, 0, 0,
-                   menu->width, menu->height);
+                   menu->width, menu->viewHeight);
 
+   if(menu->label && menu->scrollOffset < menu->itemHeight) {
+      DrawMenuItem(menu, NULL, -1);
+   }
+
+   if(menu->itemCount > 0) {
+      index = Max(GetMenuIndex(menu, 0), 0);
+      while(index < menu->itemCount) {
+         if(menu->offsets[index] - menu->scrollOffset >= menu->viewHeight) {
+            break;
+         }
+         DrawMenuItem(menu, menu->itemList[index], index);
+         index += 1;
+      }
+   }
+
+   DrawMenuBorder(menu);
+   JXCopyArea(display, menu->pixmap, menu->window, rootGC,
+              0, 0, menu->width, menu->viewHeight, 0, 0);
+
+}
+
+/** Draw the border of a menu. */
+void DrawMenuBorder(Menu *menu)
+{
    if(settings.menuDecorations == DECO_MOTIF) {
       JXSetForeground(display, rootGC, colors[COLOR_MENU_UP]);
       JXDrawLine(display, menu->pixmap, rootGC,
                  0, 0, menu->width, 0);
       JXDrawLine(display, menu->pixmap, rootGC,
-                 0, 0, 0, menu->height);
+                 0, 0, 0, menu->viewHeight);
 
       JXSetForeground(display, rootGC, colors[COLOR_MENU_DOWN]);
       JXDrawLine(display, menu->pixmap, rootGC,
-                 0, menu->height - 1, menu->width, menu->height - 1);
+                 0, menu->viewHeight - 1, menu->width, menu->viewHeight - 1);
       JXDrawLine(display, menu->pixmap, rootGC,
-                 menu->width - 1, 0, menu->width - 1, menu->height);
+                 menu->width - 1, 0, menu->width - 1, menu->viewHeight);
    } else {
       JXSetForeground(display, rootGC, colors[COLOR_MENU_DOWN]);
       JXDrawRectangle(display, menu->pixmap, rootGC,
-                      0, 0, menu->width - 1, menu->height - 1);
-   }
-
-   if(menu->label) {
-      DrawMenuItem(menu, NULL, -1);
+                      0, 0, menu->width - 1, menu->viewHeight - 1);
    }
-
-   x = 0;
-   for(np = menu->items; np; np = np->next) {
-      DrawMenuItem(menu, np, x);
-      ++x;
-   }
-   JXCopyArea(display, menu->pixmap, menu->window, rootGC,
-              0, 0, menu->width, menu->height, 0, 0);
-
 }
 
 /** Determine the action to take given an event. */
@@ -720,11 +800,14 @@ MenuSelectionType UpdateMotion(Menu *menu,
             (runner)(&ip->action, 0);
          }
          return MENU_SUBSELECT;
+      case ACTION_NONE:
+         UpdateSearch(menu, &event->xkey);
+         break;
       default:
          break;
       }
 
-      if(y >= 0) {
+      if(y >= 0 && y < tp->itemCount) {
          SetPosition(tp, y);
       }
 
@@ -736,7 +819,7 @@ MenuSelectionType UpdateMotion(Menu *menu,
    }
 
    /* Update the selection on the current menu */
-   if(x > 0 && y > 0 && x < menu->width && y < menu->height) {
+   if(x > 0 && y > 0 && x < menu->width && y < menu->viewHeight) {
       menu->currentIndex = GetMenuIndex(menu, y);
    } else if(menu->parent && subwindow != menu->parent->window) {
 
@@ -763,20 +846,19 @@ MenuSelectionType UpdateMotion(Menu *menu,
 
    }
 
-   /* Move the menu if needed. */
-   if(menu->height > menu->screen->height && menu->currentIndex >= 0) {
+   /* Scroll the menu if needed. */
+   if(menu->height > menu->viewHeight && menu->currentIndex >= 0) {
 
-      /* If near the top, shift down. */
-      if(y + menu->y <= 0) {
+      /* If near the top, scroll up. */
+      if(y < menu->itemHeight / 2) {
          if(menu->currentIndex > 0) {
             menu->currentIndex -= 1;
             SetPosition(menu, menu->currentIndex);
          }
       }
 
-      /* If near the bottom, shift up. */
-      if(y + menu->y + menu->itemHeight / 2
-            >= menu->screen->y + menu->screen->height) {
+      /* If near the bottom, scroll down. */
+      if(y + menu->itemHeight / 2 >= menu->viewHeight) {
          if(menu->currentIndex + 1 < menu->itemCount) {
             menu->currentIndex += 1;
             SetPosition(menu, menu->currentIndex);
@@ -795,7 +877,8 @@ MenuSelectionType UpdateMotion(Menu *menu,
    if(ip && IsMenuValid(ip->submenu)) {
       const int x = menu->x + menu->width
                   - (settings.menuDecorations == DECO_MOTIF ? 0 : 1);
-      const int y = menu->y + menu->offsets[menu->currentIndex] - 1;
+      const int y = menu->y + menu->offsets[menu->currentIndex]
+                  - menu->scrollOffset - 1;
       if(ShowSubmenu(ip->submenu, menu, runner, x, y, 0)) {
 
          /* Item selected; destroy the menu tree. */
@@ -829,9 +912,35 @@ void UpdateMenu(Menu *menu)
       DrawMenuItem(menu, ip, menu->currentIndex);
    }
 
-   JXCopyArea(display, menu->pixmap, menu->window, rootGC,
-              0, 0, menu->width, menu->height, 0, 0);
+   /* Copy only the items that changed. */
+   DrawMenuBorder(menu);
+   CopyMenuItem(menu, menu->lastIndex);
+   CopyMenuItem(menu, menu->currentIndex);
+
+}
+
+/** Copy a menu item from the pixmap to the menu window. */
+void CopyMenuItem(Menu *menu, int index)
+{
+   int y, height;
+
+   if(index < 0) {
+      return;
+   }
 
+   y = menu->offsets[index] - menu->scrollOffset;
+   height = GetMenuItemHeight(menu, index);
+   if(y < 0) {
+      height += y;
+      y = 0;
+   }
+   if(y + height > menu->viewHeight) {
+      height = menu->viewHeight - y;
+   }
+   if(height > 0) {
+      JXCopyArea(display, menu->pixmap, menu->window, rootGC,
+                 0, y, menu->width, height, 0, y);
+   }
 }
 
 /** Draw a menu item. */
@@ -839,6 +948,7 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
 {
 
    ButtonNode button;
+   int top;
 
    Assert(menu);
 
@@ -846,7 +956,7 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
       if(index == -1 && menu->label) {
          ResetButton(&button, menu->pixmap);
          button.x = MENU_BORDER_SIZE;
-         button.y = MENU_BORDER_SIZE;
+         button.y = MENU_BORDER_SIZE - menu->scrollOffset;
          button.width = menu->width - MENU_BORDER_SIZE * 2;
          button.height = menu->itemHeight - 1;
          button.font = FONT_MENU;
@@ -859,6 +969,7 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
       return;
    }
 
+   top = menu->offsets[index] - menu->scrollOffset;
    if(item->type != MENU_ITEM_SEPARATOR) {
       ColorType fg;
 
@@ -872,7 +983,7 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
       }
 
       button.x = MENU_BORDER_SIZE;
-      button.y = menu->offsets[index];
+      button.y = top;
       button.font = FONT_MENU;
       button.width = menu->width - MENU_BORDER_SIZE * 2;
       button.height = menu->itemHeight;
@@ -883,7 +994,7 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
       if(item->submenu) {
 
          const int asize = (menu->itemHeight + 7) / 8;
-         const int y = menu->offsets[index] + (menu->itemHeight + 1) / 2;
+         const int y = top + (menu->itemHeight + 1) / 2;
          int x = menu->width - 2 * asize - 1;
          int i;
 
@@ -902,17 +1013,14 @@ void DrawMenuItem(Menu *menu, MenuItem *item, int index)
       if(settings.menuDecorations == DECO_MOTIF) {
          JXSetForeground(display, rootGC, colors[COLOR_MENU_DOWN]);
          JXDrawLine(display, menu->pixmap, rootGC, 4,
-                    menu->offsets[index] + 2, menu->width - 6,
-                    menu->offsets[index] + 2);
+                    top + 2, menu->width - 6, top + 2);
          JXSetForeground(display, rootGC, colors[COLOR_MENU_UP]);
          JXDrawLine(display, menu->pixmap, rootGC, 4,
-                    menu->offsets[index] + 3, menu->width - 6,
-                    menu->offsets[index] + 3);
+                    top + 3, menu->width - 6, top + 3);
       } else {
          JXSetForeground(display, rootGC, colors[COLOR_MENU_FG]);
          JXDrawLine(display, menu->pixmap, rootGC, 4,
-                    menu->offsets[index] + 2, menu->width - 6,
-                    menu->offsets[index] + 2);
+                    top + 2, menu->width - 6, top + 2);
       }
    }
 
@@ -970,66 +1078,90 @@ int GetPreviousMenuIndex(Menu *menu)
    return menu->currentIndex;
 }
 
-/** Get the item in the menu given a y-coordinate. */
+/** Get the item in the menu given a y-coordinate in the menu window. */
 int GetMenuIndex(Menu *menu, int y)
 {
 
-   int x;
+   int low, high, mid;
 
-   if(y < menu->offsets[0]) {
+   y += menu->scrollOffset;
+   if(menu->itemCount == 0 || y < menu->offsets[0]) {
       return -1;
    }
-   for(x = 0; x < menu->itemCount - 1; x++) {
-      if(y >= menu->offsets[x] && y < menu->offsets[x + 1]) {
-         return x;
+
+   /* Find the last item starting at or above y. */
+   low = 0;
+   high = menu->itemCount - 1;
+   while(low < high) {
+      mid = (low + high + 1) / 2;
+      if(menu->offsets[mid] <= y) {
+         low = mid;
+      } else {
+         high = mid - 1;
       }
    }
-   return x;
+   return low;
 
 }
 
 /** Get the menu item associated with an index. */
 MenuItem *GetMenuItem(Menu *menu, int index)
 {
+   if(index >= 0 && index < menu->itemCount) {
+      return menu->itemList[index];
+   } else {
+      return NULL;
+   }
+}
 
-   MenuItem *ip;
-
-   if(index >= 0) {
-      for(ip = menu->items; ip; ip = ip->next) {
-         if(!index) {
-            return ip;
-         }
-         --index;
-      }
+/** Get the height of a menu item. */
+int GetMenuItemHeight(const Menu *menu, int index)
+{
+   if(index + 1 < menu->itemCount) {
+      return menu->offsets[index + 1] - menu->offsets[index];
    } else {
-      ip = NULL;
+      return menu->height - MENU_BORDER_SIZE - menu->offsets[index];
    }
+}
 
-   return ip;
+/** Scroll a menu so that an item is visible.
+ * @return 1 if the menu was scrolled, 0 otherwise.
+ */
+char ScrollMenu(Menu *menu, int index)
+{
+   const int top = menu->offsets[index];
+   const int bottom = top + GetMenuItemHeight(menu, index);
+   int offset = menu->scrollOffset;
+
+   if(menu->height <= menu->viewHeight) {
+      return 0;
+   }
 
+   if(top - offset < MENU_BORDER_SIZE) {
+      /* Show the label when moving to the first item. */
+      offset = index > 0 ? top - MENU_BORDER_SIZE : 0;
+   } else if(bottom - offset > menu->viewHeight - MENU_BORDER_SIZE) {
+      offset = bottom - menu->viewHeight + MENU_BORDER_SIZE;
+   }
+   offset = Min(offset, menu->height - menu->viewHeight);
+   offset = Max(offset, 0);
+
+   if(offset == menu->scrollOffset) {
+      return 0;
+   }
+   menu->scrollOffset = offset;
+   return 1;
 }
 
 /** Set the active menu item. */
 void SetPosition(Menu *tp, int index)
 {
-   int y = tp->offsets[index] + tp->itemHeight / 2;
-   if(tp->height > tp->screen->height) {
-
-      int updated = 0;
-      while(y + tp->y < tp->itemHeight / 2) {
-         tp->y += tp->itemHeight;
-         updated = tp->itemHeight;
-      }
-      while(y + tp->y >= tp->screen->y + tp->screen->height) {
-         tp->y -= tp->itemHeight;
-         updated = -tp->itemHeight;
-      }
-      if(updated) {
-         JXMoveWindow(display, tp->window, tp->x, tp->y);
-         y += updated;
-      }
+   int y;
 
+   if(ScrollMenu(tp, index)) {
+      DrawMenu(tp);
    }
+   y = tp->offsets[index] - tp->scrollOffset + tp->itemHeight / 2;
 
    /* We need to do this twice so the event gets registered
     * on the submenu if one exists. */
@@ -1052,3 +1184,204 @@ char IsMenuValid(const Menu *menu)
    return 0;
 }
 
+/** Create the search key for a menu item. */
+char *CreateSearchKey(const char *name)
+{
+   char *key = CopyString(name);
+   if(key) {
+      char *ch;
+      for(ch = key; *ch; ch++) {
+         *ch = tolower((unsigned char)*ch);
+      }
+   }
+   return key;
+}
+
+/** Update the type-to-filter search of a menu for a key press. */
+void UpdateSearch(Menu *menu, XKeyEvent *event)
+{
+   char buffer[8];
+   int count;
+   int i;
+
+   count = JXLookupString(event, buffer, sizeof(buffer), NULL, NULL);
+   if(count <= 0) {
+      return;
+   }
+
+   if(buffer[0] == '\b' || buffer[0] == 0x7F) {
+
+      /* Backspace: start over from the whole tree. */
+      if(search.menu == NULL || search.length == 0) {
+         return;
+      }
+      search.length -= 1;
+      search.text[search.length] = 0;
+      if(search.length == 0) {
+         EndSearch(menu);
+         ResizeMenuWindow(menu);
+         return;
+      }
+      search.resultCount = 0;
+      SearchMenu(menu);
+
+   } else {
+
+      /* Add printable characters to the search text. */
+      for(i = 0; i < count; i++) {
+         const unsigned char ch = (unsigned char)buffer[i];
+         if(ch < 0x20 || ch == 0x7F) {
+            return;
+         }
+      }
+      if(search.length + count >= MENU_SEARCH_SIZE) {
+         return;
+      }
+      for(i = 0; i < count; i++) {
+         search.text[search.length++] = tolower((unsigned char)buffer[i]);
+      }
+      search.text[search.length] = 0;
+
+      if(search.menu == NULL) {
+         search.menu = menu;
+         search.label = menu->label;
+         search.itemList = menu->itemList;
+         search.offsets = menu->offsets;
+         search.itemCount = menu->itemCount;
+         search.height = menu->height;
+         search.resultCount = 0;
+         SearchMenu(menu);
+      } else {
+         /* The new text can only match a subset of the old results. */
+         NarrowSearch();
+      }
+
+   }
+
+   ShowSearchResults();
+}
+
+/** Add the items matching the search text in a menu tree. */
+void SearchMenu(const Menu *menu)
+{
+   MenuItem *np;
+   unsigned int i;
+
+   /* The keys are indexed in list order, which a search does not change. */
+   i = 0;
+   for(np = menu->items; np; np = np->next) {
+      if(np->submenu) {
+         SearchMenu(np->submenu);
+      } else if(np->type == MENU_ITEM_NORMAL && menu->keys[i]) {
+         if(strstr(menu->keys[i], search.text)) {
+            AddSearchResult(np, menu->keys[i]);
+         }
+      }
+      i += 1;
+   }
+}
+
+/** Remove results that no longer match the search text. */
+void NarrowSearch(void)
+{
+   unsigned int i, count;
+   count = 0;
+   for(i = 0; i < search.resultCount; i++) {
+      if(strstr(search.resultKeys[i], search.text)) {
+         search.results[count] = search.results[i];
+         search.resultKeys[count] = search.resultKeys[i];
+         count += 1;
+      }
+   }
+   search.resultCount = count;
+}
+
+/** Add an item to the search results. */
+void AddSearchResult(MenuItem *item, const char *key)
+{
+   if(search.resultCount >= search.resultMax) {
+      search.resultMax = search.resultMax ? search.resultMax * 2 : 16;
+      search.results = Reallocate(search.results,
+                                  sizeof(MenuItem*) * search.resultMax);
+      search.resultKeys = Reallocate(search.resultKeys,
+                                     sizeof(char*) * search.resultMax);
+      search.resultOffsets = Reallocate(search.resultOffsets,
+                                        sizeof(int) * search.resultMax);
+   }
+   search.results[search.resultCount] = item;
+   search.resultKeys[search.resultCount] = key;
+   search.resultCount += 1;
+}
+
+/** Show the search results in place of the menu items. */
+void ShowSearchResults(void)
+{
+   Menu *menu = search.menu;
+   unsigned int i;
+
+   /* The search text is shown as the label. */
+   menu->label = search.text;
+   menu->height = MENU_BORDER_SIZE + menu->itemHeight;
+   for(i = 0; i < search.resultCount; i++) {
+      search.resultOffsets[i] = menu->height;
+      menu->height += menu->itemHeight;
+   }
+   menu->height += MENU_BORDER_SIZE;
+   menu->itemList = search.results;
+   menu->offsets = search.resultOffsets;
+   menu->itemCount = search.resultCount;
+
+   ResizeMenuWindow(menu);
+}
+
+/** Stop searching a menu and restore its items. */
+void EndSearch(Menu *menu)
+{
+   if(search.menu == menu) {
+      menu->label = search.label;
+      menu->itemList = search.itemList;
+      menu->offsets = search.offsets;
+      menu->itemCount = search.itemCount;
+      menu->height = search.height;
+      menu->currentIndex = -1;
+      menu->lastIndex = -1;
+      search.menu = NULL;
+      search.length = 0;
+      search.text[0] = 0;
+      search.resultCount = 0;
+      search.resultMax = 0;
+      if(search.results) {
+         Release(search.results);
+         Release(search.resultKeys);
+         Release(search.resultOffsets);
+         search.results = NULL;
+         search.resultKeys = NULL;
+         search.resultOffsets = NULL;
+      }
+   }
+}
+
+/** Resize the window of a menu after its items changed. */
+void ResizeMenuWindow(Menu *menu)
+{
+   const int bottom = menu->screen->y + menu->screen->height;
+   int y = menu->y;
+
+   menu->viewHeight = Min(menu->height, menu->screen->height);
+   menu->scrollOffset = 0;
+   if(y + menu->viewHeight > bottom) {
+      y = bottom - menu->viewHeight;
+   }
+   menu->parentOffset += menu->y - y;
+   menu->y = y;
+
+   JXMoveResizeWindow(display, menu->window, menu->x, menu->y,
+                      menu->width, menu->viewHeight);
+   JXFreePixmap(display, menu->pixmap);
+   menu->pixmap = JXCreatePixmap(display, menu->window,
+                                 menu->width, menu->viewHeight, rootDepth);
+
+   menu->currentIndex = menu->itemCount > 0 ? 0 : -1;
+   menu->lastIndex = menu->currentIndex;
+   DrawMenu(menu);
+}
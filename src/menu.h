@@ -94,13 +94,17 @@ typedef struct Menu {
    int x;                  /**< The x-coordinate of the menu. */
    int y;                  /**< The y-coordinate of the menu. */
    int width;              /**< The width of the menu. */
-   int height;             /**< The height of the menu. */
+   int height;             /**< The height of the menu contents. */
+   int viewHeight;         /**< The height of the menu window. */
+   int scrollOffset;       /**< y-offset of the contents in the window. */
    int currentIndex;       /**< The current menu selection. */
    int lastIndex;          /**< The last menu selection. */
    unsigned int itemCount; /**< Number of menu items (excluding separators). */
    int parentOffset;       /**< y-offset of this menu wrt the parent. */
    int textOffset;         /**< x-offset of text in the menu. */
    int *offsets;           /**< y-offsets of menu items. */
+   struct MenuItem **itemList;   /**< Menu items by index. */
+   char **keys;            /**< Lowercase item names for searching. */
    struct Menu *parent;    /**< The parent menu (or NULL). */
    const struct ScreenType *screen;
    int mousex, mousey;
@@ -116,6 +120,11 @@ Menu *CreateMenu();
 /** Create an empty menu item. */
 MenuItem *CreateMenuItem(MenuItemType type);
 
+/** Get the size of client icons in menus with the default item height.
+ * @return The size in pixels (note that icons are square).
+ */
+int GetMenuIconSize(void);
+
 /** Initialize a menu structure to be shown.
  * @param menu The menu to initialize.
  */
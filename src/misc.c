@@ -11,6 +11,11 @@
 #include "misc.h"
 #include "debug.h"
 
+#ifdef HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#  include <errno.h>
+#endif
+
 static char ToLower(char ch);
 static char IsSymbolic(char ch);
 static char *GetSymbolName(const char *str);
@@ -284,3 +289,143 @@ int StrCmpNoCase(const char *a, const char *b)
    }
    return *b - *a;
 }
+
+/** Compute a hash of a string. */
+unsigned int HashString(const char *str)
+{
+   unsigned int h = 2166136261U;
+   while(*str) {
+      h ^= (unsigned char)*str;
+      h *= 16777619U;
+      str += 1;
+   }
+   return h;
+}
+
+/** Compute a hash of a block of memory. */
+unsigned int HashData(const void *data, size_t len)
+{
+   const unsigned char *ptr = (const unsigned char*)data;
+   unsigned int h = 2166136261U;
+   while(len > 0) {
+      h ^= *ptr;
+      h *= 16777619U;
+      ptr += 1;
+      len -= 1;
+   }
+   return h;
+}
+
+/** Get the path of a file in the cache directory. */
+char *GetCachePath(const char *name)
+{
+   static const char DIR[] = "/jwm/";
+   const char *base = getenv("XDG_CACHE_HOME");
+   const char *suffix = "";
+   size_t len;
+   char *path;
+
+   if(!base || base[0] != '/') {
+      base = getenv("HOME");
+      suffix = "/.cache";
+      if(!base || !base[0]) {
+         return NULL;
+      }
+   }
+   len = strlen(base) + strlen(suffix) + sizeof(DIR) + strlen(name);
+   path = Allocate(len);
+   snprintf(path, len, "%s%s%s%s", base, suffix, DIR, name);
+   return path;
+}
+
+#ifdef HAVE_SYS_STAT_H
+
+/** Files modified this recently (in seconds) are not cached. */
+#define MIN_FILE_AGE 2
+
+/** Get the key for a version of a file. */
+void GetFileKey(const struct stat *st, FileKey *key)
+{
+   memset(key, 0, sizeof(FileKey));
+   key->mtime = (long)st->st_mtime;
+#if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+   key->mtimeNsec = (long)st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMENSEC)
+   key->mtimeNsec = (long)st->st_mtimensec;
+#endif
+   key->ctime = (long)st->st_ctime;
+   key->size = (long)st->st_size;
+   key->inode = (unsigned long)st->st_ino;
+}
+
+/** Determine if a file was modified too recently to be cached. */
+char IsFileRecent(const struct stat *st)
+{
+   return (long)st->st_mtime > (long)time(NULL) - MIN_FILE_AGE;
+}
+
+/** Create the parent directories of a file. */
+char MakeDirectories(char *path)
+{
+   char *ptr;
+   for(ptr = strchr(path + 1, '/'); ptr; ptr = strchr(ptr + 1, '/')) {
+      *ptr = 0;
+      if(mkdir(path, 0700) < 0 && errno != EEXIST) {
+         *ptr = '/';
+         return 0;
+      }
+      *ptr = '/';
+   }
+   return 1;
+}
+
+/** Create a uniquely named file next to a file to be replaced.
+ * A fixed name would let two instances sharing the cache directory
+ * interleave their writes.
+ */
+FILE *CreateReplacement(const char *path, char **tempPath)
+{
+   static const char SUFFIX[] = ".XXXXXX";
+   const size_t len = strlen(path) + sizeof(SUFFIX);
+   FILE *fd;
+   int handle;
+
+   *tempPath = Allocate(len);
+   snprintf(*tempPath, len, "%s%s", path, SUFFIX);
+   fd = NULL;
+   if(MakeDirectories(*tempPath)) {
+      handle = mkstemp(*tempPath);
+      if(handle >= 0) {
+         fd = fdopen(handle, "wb");
+         if(JUNLIKELY(!fd)) {
+            close(handle);
+            unlink(*tempPath);
+         }
+      }
+   }
+   if(!fd) {
+      Release(*tempPath);
+      *tempPath = NULL;
+   }
+   return fd;
+}
+
+/** Finish writing a file created with CreateReplacement. */
+char ReplaceFile(FILE *fd, char *tempPath, const char *path)
+{
+   char ok = !ferror(fd);
+   if(fflush(fd) != 0 || fsync(fileno(fd)) != 0) {
+      ok = 0;
+   }
+   if(fclose(fd) != 0) {
+      ok = 0;
+   }
+   if(!ok || rename(tempPath, path) < 0) {
+      unlink(tempPath);
+      ok = 0;
+   }
+   Release(tempPath);
+   return ok;
+}
+
+#endif
@@ -78,4 +78,79 @@ const char *FindKey(const StringMappingType *mapping, int count, int value);
 /** Case insensitive string compare. */
 int StrCmpNoCase(const char *a, const char *b);
 
+/** Compute a hash of a string (FNV-1a).
+ * @param str The string.
+ * @return The hash.
+ */
+unsigned int HashString(const char *str);
+
+/** Compute a hash of a block of memory (FNV-1a).
+ * @param data The data.
+ * @param len The number of bytes.
+ * @return The hash.
+ */
+unsigned int HashData(const void *data, size_t len);
+
+/** Get the path of a file in the cache directory.
+ * This is $XDG_CACHE_HOME/jwm/name (or ~/.cache/jwm/name).
+ * @param name The name of the file.
+ * @return The path (NULL if unknown), to be released with Release.
+ */
+char *GetCachePath(const char *name);
+
+#ifdef HAVE_SYS_STAT_H
+
+struct stat;
+
+/** Identifies a version of a file in the caches. */
+typedef struct FileKey {
+   long mtime;                /**< Modification time of the file. */
+   long mtimeNsec;            /**< Nanoseconds of the modification time. */
+   long ctime;                /**< Status change time of the file. */
+   long size;                 /**< Size of the file. */
+   unsigned long inode;       /**< Inode of the file. */
+} FileKey;
+
+/** Get the key for a version of a file.
+ * Nanoseconds are used where the platform provides them.
+ * @param st The status of the file.
+ * @param key The key to set.
+ */
+void GetFileKey(const struct stat *st, FileKey *key);
+
+/** Determine if a file was modified too recently to be cached.
+ * A further edit within the same timestamp tick could go unnoticed.
+ * @param st The status of the file.
+ * @return 1 if the file is too new, 0 otherwise.
+ */
+char IsFileRecent(const struct stat *st);
+
+/** Create the parent directories of a file.
+ * @param path The file (modified temporarily).
+ * @return 1 on success, 0 on failure.
+ */
+char MakeDirectories(char *path);
+
+/** Create a uniquely named file next to a file to be replaced.
+ * The parent directories are created if needed. The file should be
+ * finished with ReplaceFile.
+ * @param path The file to be replaced.
+ * @param tempPath Set to the name of the new file (to be released with
+ *        Release), or NULL on failure.
+ * @return The new file open for writing (NULL on failure).
+ */
+FILE *CreateReplacement(const char *path, char **tempPath);
+
+/** Finish writing a file created with CreateReplacement.
+ * The file is synced and renamed over the original, or removed if
+ * anything failed. The file is closed and tempPath is released.
+ * @param fd The file.
+ * @param tempPath The name of the file.
+ * @param path The file to replace.
+ * @return 1 on success, 0 on failure.
+ */
+char ReplaceFile(FILE *fd, char *tempPath, const char *path);
+
+#endif
+
 #endif /* MISC_H */
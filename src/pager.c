@@ -21,6 +21,7 @@
 #include "popup.h"
 #include "font.h"
 #include "settings.h"
+#include "misc.h"
 
 /** Structure to represent a pager tray component. */
 typedef struct PagerType {
@@ -32,8 +33,13 @@ typedef struct PagerType {
    int scalex;             /**< Horizontal scale factor (fixed point). */
    int scaley;             /**< Vertical scale factor (fixed point). */
    char labeled;           /**< Set to label the pager. */
+   char thumbnails;        /**< Set to show window thumbnails. */
 
    Pixmap buffer;          /**< Buffer for rendering the pager. */
+   Pixmap background;      /**< Desktops with labels. */
+   Pixmap activeBackground;   /**< Desktops with labels (current desktop). */
+   unsigned int *deskHashes;  /**< Hash of each desktop as drawn. */
+   char invalid;           /**< Set to redraw all desktops. */
 
    TimeType mouseTime;     /**< Timestamp of last mouse movement. */
    int mousex, mousey;     /**< Coordinates of last mouse location. */
@@ -42,8 +48,71 @@ typedef struct PagerType {
 
 } PagerType;
 
+/** Location of a client drawn on the pager. */
+typedef struct PagerShapeType {
+   unsigned int desktop;   /**< Desktop containing the client. */
+   int x, y;               /**< Location on the pager. */
+   int width, height;      /**< Size on the pager. */
+   ColorType fillColor;    /**< Fill color. */
+   const ClientNode *client;  /**< The client. */
+   int sx, sy;             /**< Offset of the clipped area. */
+   int fullWidth;          /**< Width before clipping. */
+   int fullHeight;         /**< Height before clipping. */
+   unsigned int serial;    /**< Thumbnail serial (0 for an outline). */
+} PagerShapeType;
+
 static PagerType *pagers = NULL;
 
+#ifdef USE_XCOMPOSITE
+
+/** Minimum number of milliseconds between thumbnail updates of a window.
+ * This keeps windows that are constantly redrawn (video, for example)
+ * from causing the pager to be redrawn continuously.
+ */
+#define THUMBNAIL_INTERVAL    250
+
+/** Milliseconds a pager update with thumbnails is allowed to take. */
+#define THUMBNAIL_BUDGET      20
+
+/** Milliseconds to draw outlines after going over the budget. */
+#define THUMBNAIL_BACKOFF     5000
+
+#define THUMBNAIL_HASH_SIZE   64
+
+/** Thumbnail of a client frame.
+ * The frame is redirected so that the server keeps its contents in a
+ * pixmap. The named pixmap keeps the last contents after the frame is
+ * unmapped, so windows on other desktops keep their thumbnails.
+ */
+typedef struct ThumbnailType {
+   Window window;          /**< The frame window. */
+   Damage damage;          /**< Damage object for the frame. */
+   Pixmap pixmap;          /**< Named frame pixmap (None if not shown yet). */
+   Picture picture;        /**< Picture for the named pixmap. */
+   int width, height;      /**< Size of the named pixmap. */
+   TimeType updateTime;    /**< Time of the last accepted update. */
+   unsigned int serial;    /**< Incremented when the contents change. */
+   char viewable;          /**< Set if the frame was viewable. */
+   char damaged;           /**< Set if there is damage not yet shown. */
+   struct ThumbnailType *next;
+} ThumbnailType;
+
+static ThumbnailType *thumbnails[THUMBNAIL_HASH_SIZE];
+static char thumbnailsSuspended = 0;
+static char thumbnailsPending = 0;
+static TimeType suspendTime;
+static unsigned int thumbnailsDrawn;
+
+static ThumbnailType *FindThumbnail(Window w);
+static void UpdateThumbnails(void);
+static void UpdateThumbnail(ThumbnailType *tp, const ClientNode *np);
+static void DestroyThumbnail(ThumbnailType *tp);
+static void DrawThumbnail(const PagerType *pp, const PagerShapeType *shape);
+static void SignalThumbnails(const TimeType *now, int x, int y, Window w,
+                             void *data);
+
+#endif /* USE_XCOMPOSITE */
+
 static char shouldStopMove;
 
 static void Create(TrayComponentType *cp);
@@ -65,9 +134,19 @@ static void StopPagerMove(ClientNode *np,
 
 static void PagerMoveController(int wasDestroyed);
 
-static void DrawPager(const PagerType *pp);
+static void CreateBuffers(PagerType *pp);
+
+static void DrawPagerBackground(const PagerType *pp, Pixmap d,
+                                ColorType bg);
+
+static void DrawPager(PagerType *pp);
+
+static char GetPagerShape(const PagerType *pp, const ClientNode *np,
+                          PagerShapeType *shape);
+
+static void DrawPagerClient(const PagerType *pp, const PagerShapeType *shape);
 
-static void DrawPagerClient(const PagerType *pp, const ClientNode *np);
+static unsigned int MixHash(unsigned int hash, int value);
 
 static void SignalPager(const TimeType *now, int x, int y, Window w,
                         void *data);
@@ -77,8 +156,23 @@ static void SignalPager(const TimeType *now, int x, int y, Window w,
 void ShutdownPager(void)
 {
    PagerType *pp;
+#ifdef USE_XCOMPOSITE
+   unsigned int x;
+   for(x = 0; x < THUMBNAIL_HASH_SIZE; x++) {
+      while(thumbnails[x]) {
+         ThumbnailType *tp = thumbnails[x]->next;
+         DestroyThumbnail(thumbnails[x]);
+         thumbnails[x] = tp;
+      }
+   }
+   thumbnailsSuspended = 0;
+   thumbnailsPending = 0;
+#endif
    for(pp = pagers; pp; pp = pp->next) {
       JXFreePixmap(display, pp->buffer);
+      JXFreePixmap(display, pp->background);
+      JXFreePixmap(display, pp->activeBackground);
+      Release(pp->deskHashes);
    }
 }
 
@@ -88,6 +182,11 @@ void DestroyPager(void)
    PagerType *pp;
    while(pagers) {
       UnregisterCallback(SignalPager, pagers);
+#ifdef USE_XCOMPOSITE
+      if(pagers->thumbnails) {
+         UnregisterCallback(SignalThumbnails, pagers);
+      }
+#endif
       pp = pagers->next;
       Release(pagers);
       pagers = pp;
@@ -95,7 +194,7 @@ void DestroyPager(void)
 }
 
 /** Create a new pager tray component. */
-TrayComponentType *CreatePager(char labeled)
+TrayComponentType *CreatePager(char labeled, char thumbnails)
 {
 
    TrayComponentType *cp;
@@ -105,11 +204,16 @@ TrayComponentType *CreatePager(char labeled)
    pp->next = pagers;
    pagers = pp;
    pp->labeled = labeled;
+   pp->thumbnails = thumbnails;
    pp->mousex = -settings.doubleClickDelta;
    pp->mousey = -settings.doubleClickDelta;
    pp->mouseTime.seconds = 0;
    pp->mouseTime.ms = 0;
    pp->buffer = None;
+   pp->background = None;
+   pp->activeBackground = None;
+   pp->deskHashes = NULL;
+   pp->invalid = 1;
 
    cp = CreateTrayComponent();
    cp->object = pp;
@@ -120,6 +224,11 @@ TrayComponentType *CreatePager(char labeled)
    cp->ProcessMotionEvent = ProcessPagerMotionEvent;
 
    RegisterCallback(settings.popupDelay / 2, SignalPager, pp);
+#ifdef USE_XCOMPOSITE
+   if(thumbnails) {
+      RegisterCallback(THUMBNAIL_INTERVAL, SignalThumbnails, pp);
+   }
+#endif
 
    return cp;
 }
@@ -139,10 +248,78 @@ void Create(TrayComponentType *cp)
    Assert(cp->width > 0);
    Assert(cp->height > 0);
 
+   pp->deskHashes = Allocate(settings.desktopCount * sizeof(unsigned int));
+   CreateBuffers(pp);
+
+}
+
+/** Create the pixmaps for a pager.
+ * The desktop backgrounds and labels are drawn once here and copied
+ * under desktops that change.
+ */
+void CreateBuffers(PagerType *pp)
+{
+   TrayComponentType *cp = pp->cp;
+
    cp->pixmap = JXCreatePixmap(display, rootWindow, cp->width,
                                cp->height, rootDepth);
    pp->buffer = cp->pixmap;
 
+   pp->background = JXCreatePixmap(display, rootWindow, cp->width,
+                                   cp->height, rootDepth);
+   DrawPagerBackground(pp, pp->background, COLOR_PAGER_BG);
+   pp->activeBackground = JXCreatePixmap(display, rootWindow, cp->width,
+                                         cp->height, rootDepth);
+   DrawPagerBackground(pp, pp->activeBackground, COLOR_PAGER_ACTIVE_BG);
+
+   pp->invalid = 1;
+}
+
+/** Draw the desktop backgrounds, labels, and dividers of a pager. */
+void DrawPagerBackground(const PagerType *pp, Pixmap d, ColorType bg)
+{
+   const int width = pp->cp->width;
+   const int height = pp->cp->height;
+   const int deskWidth = pp->deskWidth;
+   const int deskHeight = pp->deskHeight;
+   unsigned int x;
+
+   JXSetForeground(display, rootGC, colors[bg]);
+   JXFillRectangle(display, d, rootGC, 0, 0, width, height);
+
+   /* Draw the labels. */
+   if(pp->labeled) {
+      const int textHeight = GetStringHeight(FONT_PAGER);
+      if(textHeight < deskHeight) {
+         for(x = 0; x < settings.desktopCount; x++) {
+            const char *name = GetDesktopName(x);
+            const int textWidth = GetStringWidth(FONT_PAGER, name);
+            if(textWidth < deskWidth) {
+               const int dx = x % settings.desktopWidth;
+               const int dy = x / settings.desktopWidth;
+               const int xc = dx * (deskWidth + 1)
+                            + (deskWidth - textWidth) / 2;
+               const int yc = dy * (deskHeight + 1)
+                            + (deskHeight - textHeight) / 2;
+               RenderString(d, FONT_PAGER, COLOR_PAGER_TEXT,
+                            xc, yc, deskWidth, name);
+            }
+         }
+      }
+   }
+
+   /* Draw the desktop dividers. */
+   JXSetForeground(display, rootGC, colors[COLOR_PAGER_OUTLINE]);
+   for(x = 1; x < settings.desktopHeight; x++) {
+      JXDrawLine(display, d, rootGC,
+                 0, (deskHeight + 1) * x - 1,
+                 width, (deskHeight + 1) * x - 1);
+   }
+   for(x = 1; x < settings.desktopWidth; x++) {
+      JXDrawLine(display, d, rootGC,
+                 (deskWidth + 1) * x - 1, 0,
+                 (deskWidth + 1) * x - 1, height);
+   }
 }
 
 /** Set the size of a pager tray component. */
@@ -177,17 +354,17 @@ void SetSize(TrayComponentType *cp, int width, int height)
       Assert(0);
    }
 
+   pp->scalex = ((pp->deskWidth - 2) << 16) / rootWidth;
+   pp->scaley = ((pp->deskHeight - 2) << 16) / rootHeight;
+
    if(pp->buffer != None) {
       JXFreePixmap(display, pp->buffer);
-      pp->buffer = JXCreatePixmap(display, rootWindow, cp->width,
-                                  cp->height, rootDepth);
-      cp->pixmap = pp->buffer;
-      DrawPager(pp);
+      JXFreePixmap(display, pp->background);
+      JXFreePixmap(display, pp->activeBackground);
+      CreateBuffers(pp);
+      RequirePagerUpdate();
    }
 
-   pp->scalex = ((pp->deskWidth - 2) << 16) / rootWidth;
-   pp->scaley = ((pp->deskHeight - 2) << 16) / rootHeight;
-
 }
 
 /** Get the desktop for a pager given a set of coordinates. */
@@ -443,7 +620,8 @@ ClientFound:
          /* Move the window. */
          np->x = oldx;
          np->y = oldy;
-         JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+         JXMoveWindow(display, np->parent,
+                      GetClientFrameX(np, np->x - west), np->y - north);
          SendConfigureEvent(np);
          RequirePagerUpdate();
 
@@ -474,7 +652,8 @@ void StopPagerMove(ClientNode *np,
    np->y = y;
 
    GetBorderSize(&np->state, &north, &south, &east, & west);
-   JXMoveWindow(display, np->parent, np->x - west, np->y - north);
+   JXMoveWindow(display, np->parent,
+                GetClientFrameX(np, np->x - west), np->y - north);
    SendConfigureEvent(np);
 
    /* Restore the maximized state of the client. */
@@ -497,76 +676,92 @@ void PagerMoveController(int wasDestroyed)
 
 }
 
-/** Draw a pager. */
-void DrawPager(const PagerType *pp)
+/** Mix a value into a desktop hash (FNV-1a). */
+unsigned int MixHash(unsigned int hash, int value)
+{
+   return (hash ^ (unsigned int)value) * 16777619u;
+}
+
+/** Draw a pager.
+ * A hash of what is shown on each desktop is kept so that only desktops
+ * whose contents changed are redrawn and copied to the tray.
+ */
+void DrawPager(PagerType *pp)
 {
+   TrayComponentType *cp = pp->cp;
+   PagerShapeType shape;
+   unsigned int *hashes;
+   char *dirty;
    ClientNode *np;
-   Pixmap buffer;
-   int width, height;
-   int deskWidth, deskHeight;
    unsigned int x;
-   const char *name;
-   int xc, yc;
-   int textWidth, textHeight;
-   int dx, dy;
-
-   buffer = pp->cp->pixmap;
-   width = pp->cp->width;
-   height = pp->cp->height;
-   deskWidth = pp->deskWidth;
-   deskHeight = pp->deskHeight;
-
-   /* Draw the background. */
-   JXSetForeground(display, rootGC, colors[COLOR_PAGER_BG]);
-   JXFillRectangle(display, buffer, rootGC, 0, 0, width, height);
-
-   /* Highlight the current desktop. */
-   JXSetForeground(display, rootGC, colors[COLOR_PAGER_ACTIVE_BG]);
-   dx = currentDesktop % settings.desktopWidth;
-   dy = currentDesktop / settings.desktopWidth;
-   JXFillRectangle(display, buffer, rootGC,
-                   dx * (deskWidth + 1), dy * (deskHeight + 1),
-                   deskWidth, deskHeight);
+   char anyDirty;
 
-   /* Draw the labels. */
-   if(pp->labeled) {
-      textHeight = GetStringHeight(FONT_PAGER);
-      if(textHeight < deskHeight) {
-         for(x = 0; x < settings.desktopCount; x++) {
-            dx = x % settings.desktopWidth;
-            dy = x / settings.desktopWidth;
-            name = GetDesktopName(x);
-            textWidth = GetStringWidth(FONT_PAGER, name);
-            if(textWidth < deskWidth) {
-               xc = dx * (deskWidth + 1) + (deskWidth - textWidth) / 2;
-               yc = dy * (deskHeight + 1) + (deskHeight - textHeight) / 2;
-               RenderString(buffer, FONT_PAGER,
-                            COLOR_PAGER_TEXT, xc, yc, deskWidth, name);
-            }
+   hashes = AllocateStack(settings.desktopCount * sizeof(unsigned int));
+   dirty = AllocateStack(settings.desktopCount * sizeof(char));
+
+   /* Hash the contents of each desktop. */
+   for(x = 0; x < settings.desktopCount; x++) {
+      hashes[x] = MixHash(2166136261u, x == currentDesktop);
+   }
+   for(x = FIRST_LAYER; x <= LAST_LAYER; x++) {
+      for(np = nodeTail[x]; np; np = np->prev) {
+         if(GetPagerShape(pp, np, &shape)) {
+            unsigned int hash = hashes[shape.desktop];
+            hash = MixHash(hash, shape.x);
+            hash = MixHash(hash, shape.y);
+            hash = MixHash(hash, shape.width);
+            hash = MixHash(hash, shape.height);
+            hash = MixHash(hash, shape.serial);
+            hashes[shape.desktop] = MixHash(hash, shape.fillColor);
          }
       }
    }
 
-   /* Draw the clients. */
-   for(x = FIRST_LAYER; x <= LAST_LAYER; x++) {
-      for(np = nodeTail[x]; np; np = np->prev) {
-         DrawPagerClient(pp, np);
+   /* Restore the background of desktops that changed. */
+   anyDirty = 0;
+   for(x = 0; x < settings.desktopCount; x++) {
+      dirty[x] = pp->invalid || hashes[x] != pp->deskHashes[x];
+      if(dirty[x]) {
+         const int dx = (x % settings.desktopWidth) * (pp->deskWidth + 1);
+         const int dy = (x / settings.desktopWidth) * (pp->deskHeight + 1);
+         const Pixmap bg = x == currentDesktop
+                         ? pp->activeBackground : pp->background;
+         JXCopyArea(display, bg, pp->buffer, rootGC, dx, dy,
+                    pp->deskWidth + 1, pp->deskHeight + 1, dx, dy);
+         pp->deskHashes[x] = hashes[x];
+         anyDirty = 1;
       }
    }
 
-   /* Draw the desktop dividers. */
-   JXSetForeground(display, rootGC, colors[COLOR_PAGER_OUTLINE]);
-   for(x = 1; x < settings.desktopHeight; x++) {
-      JXDrawLine(display, buffer, rootGC,
-                 0, (deskHeight + 1) * x - 1,
-                 width, (deskHeight + 1) * x - 1);
+   /* Draw the clients on those desktops. */
+   if(anyDirty) {
+      for(x = FIRST_LAYER; x <= LAST_LAYER; x++) {
+         for(np = nodeTail[x]; np; np = np->prev) {
+            if(GetPagerShape(pp, np, &shape) && dirty[shape.desktop]) {
+               DrawPagerClient(pp, &shape);
+            }
+         }
+      }
    }
-   for(x = 1; x < settings.desktopWidth; x++) {
-      JXDrawLine(display, buffer, rootGC,
-                 (deskWidth + 1) * x - 1, 0,
-                 (deskWidth + 1) * x - 1, height);
+
+   /* Tell the tray to redraw. */
+   if(pp->invalid) {
+      UpdateSpecificTray(cp->tray, cp);
+      pp->invalid = 0;
+   } else if(anyDirty) {
+      for(x = 0; x < settings.desktopCount; x++) {
+         if(dirty[x]) {
+            const int dx = (x % settings.desktopWidth) * (pp->deskWidth + 1);
+            const int dy = (x / settings.desktopWidth) * (pp->deskHeight + 1);
+            UpdateSpecificTrayArea(cp->tray, cp, dx, dy,
+                                   pp->deskWidth + 1, pp->deskHeight + 1);
+         }
+      }
    }
 
+   ReleaseStack(dirty);
+   ReleaseStack(hashes);
+
 }
 
 /** Update the pager. */
@@ -574,20 +769,37 @@ void UpdatePager(void)
 {
 
    PagerType *pp;
+#ifdef USE_XCOMPOSITE
+   TimeType start, stop;
+#endif
 
    if(JUNLIKELY(shouldExit)) {
       return;
    }
 
-   for(pp = pagers; pp; pp = pp->next) {
+#ifdef USE_XCOMPOSITE
+   UpdateThumbnails();
+   thumbnailsDrawn = 0;
+   GetCurrentTime(&start);
+#endif
 
-      /* Draw the pager. */
+   for(pp = pagers; pp; pp = pp->next) {
       DrawPager(pp);
+   }
 
-      /* Tell the tray to redraw. */
-      UpdateSpecificTray(pp->cp->tray, pp->cp);
-
+#ifdef USE_XCOMPOSITE
+   /* Fall back to outlines if the thumbnails took too long to draw. */
+   if(thumbnailsDrawn > 0) {
+      JXSync(display, False);
+      GetCurrentTime(&stop);
+      if(GetTimeDifference(&start, &stop) > THUMBNAIL_BUDGET) {
+         Debug("pager thumbnails over budget (%lu ms)",
+               GetTimeDifference(&start, &stop));
+         thumbnailsSuspended = 1;
+         suspendTime = stop;
+      }
    }
+#endif
 
 }
 
@@ -612,40 +824,41 @@ void SignalPager(const TimeType *now, int x, int y, Window w, void *data)
    }
 }
 
-/** Draw a client on the pager. */
-void DrawPagerClient(const PagerType *pp, const ClientNode *np)
+/** Determine where a client is drawn on the pager.
+ * @return 1 if the client is visible on the pager, 0 otherwise.
+ */
+char GetPagerShape(const PagerType *pp, const ClientNode *np,
+                   PagerShapeType *shape)
 {
 
    int x, y;
    int width, height;
-   int offx, offy;
 
    /* Don't draw the client if it isn't mapped. */
    if(!(np->state.status & STAT_MAPPED)) {
-      return;
+      return 0;
    }
    /* The user will probably expect to see windows providing background
     * images and/or desktop file icons as "unoccupied space", as if there
     * were no non-root window there really. */
    if((np->state.windowType == WINDOW_TYPE_DESKTOP) ||
       (np->state.layer == LAYER_DESKTOP)) {
-      return;
+      return 0;
    }
    /* Skip anything we're specifically told to skip too. */
    if(np->state.status & STAT_NOPAGER) {
-      return;
+      return 0;
    }
 
    /* Determine the desktop for the client. */
    if(np->state.status & STAT_STICKY) {
-      offx = currentDesktop % settings.desktopWidth;
-      offy = currentDesktop / settings.desktopWidth;
+      shape->desktop = currentDesktop;
    } else {
-      offx = np->state.desktop % settings.desktopWidth;
-      offy = np->state.desktop / settings.desktopWidth;
+      shape->desktop = np->state.desktop;
+   }
+   if(JUNLIKELY(shape->desktop >= settings.desktopCount)) {
+      return 0;
    }
-   offx *= pp->deskWidth + 1;
-   offy *= pp->deskHeight + 1;
 
    /* Determine the location and size of the client on the pager. */
    x = 1 + ((np->x * pp->scalex) >> 16);
@@ -671,33 +884,287 @@ void DrawPagerClient(const PagerType *pp, const ClientNode *np)
 
    /* Return if there's nothing to do. */
    if(width <= 0 || height <= 0) {
-      return;
+      return 0;
    }
 
    /* Move to the correct desktop on the pager. */
-   x += offx;
-   y += offy;
+   shape->x = x + (shape->desktop % settings.desktopWidth)
+                * (pp->deskWidth + 1);
+   shape->y = y + (shape->desktop / settings.desktopWidth)
+                * (pp->deskHeight + 1);
+   shape->width = width;
+   shape->height = height;
+   shape->client = np;
+   shape->sx = x - (1 + ((np->x * pp->scalex) >> 16));
+   shape->sy = y - (1 + ((np->y * pp->scaley) >> 16));
+   shape->fullWidth = (np->width * pp->scalex) >> 16;
+   shape->fullHeight = (np->height * pp->scaley) >> 16;
+   shape->serial = 0;
+#ifdef USE_XCOMPOSITE
+   if(pp->thumbnails && !thumbnailsSuspended && np->parent != None
+      && width > 2 && height > 2) {
+      const ThumbnailType *tp = FindThumbnail(np->parent);
+      if(tp && tp->picture != None) {
+         shape->serial = tp->serial + 1;
+      }
+   }
+#endif
+
+   if((np->state.status & STAT_ACTIVE)
+      && (np->state.desktop == currentDesktop
+      || (np->state.status & STAT_STICKY))) {
+      shape->fillColor = COLOR_PAGER_ACTIVE_FG;
+   } else if(np->state.status & STAT_FLASH) {
+      shape->fillColor = COLOR_PAGER_ACTIVE_FG;
+   } else {
+      shape->fillColor = COLOR_PAGER_FG;
+   }
+
+   return 1;
+
+}
+
+/** Draw a client on the pager. */
+void DrawPagerClient(const PagerType *pp, const PagerShapeType *shape)
+{
 
    /* Draw the client outline. */
    JXSetForeground(display, rootGC, colors[COLOR_PAGER_OUTLINE]);
-   JXDrawRectangle(display, pp->cp->pixmap, rootGC, x, y, width, height);
+   JXDrawRectangle(display, pp->buffer, rootGC, shape->x, shape->y,
+                   shape->width, shape->height);
+
+#ifdef USE_XCOMPOSITE
+   if(shape->serial) {
+      DrawThumbnail(pp, shape);
+      return;
+   }
+#endif
 
    /* Fill the client if there's room. */
-   if(width > 1 && height > 1) {
-      ColorType fillColor;
-      if((np->state.status & STAT_ACTIVE)
-         && (np->state.desktop == currentDesktop
-         || (np->state.status & STAT_STICKY))) {
-         fillColor = COLOR_PAGER_ACTIVE_FG;
-      } else if(np->state.status & STAT_FLASH) {
-         fillColor = COLOR_PAGER_ACTIVE_FG;
+   if(shape->width > 1 && shape->height > 1) {
+      JXSetForeground(display, rootGC, colors[shape->fillColor]);
+      JXFillRectangle(display, pp->buffer, rootGC,
+                      shape->x + 1, shape->y + 1,
+                      shape->width - 1, shape->height - 1);
+   }
+
+}
+
+#ifdef USE_XCOMPOSITE
+
+/** Find the thumbnail for a frame window. */
+ThumbnailType *FindThumbnail(Window w)
+{
+   ThumbnailType *tp;
+   for(tp = thumbnails[w % THUMBNAIL_HASH_SIZE]; tp; tp = tp->next) {
+      if(tp->window == w) {
+         return tp;
+      }
+   }
+   return NULL;
+}
+
+/** Create, refresh, and accept damage for thumbnails of all clients.
+ * This is done once per pager update so that all pagers agree.
+ */
+void UpdateThumbnails(void)
+{
+   PagerType *pp;
+   ClientNode *np;
+   unsigned int layer;
+
+   if(!haveComposite || thumbnailsSuspended) {
+      return;
+   }
+   for(pp = pagers; pp; pp = pp->next) {
+      if(pp->thumbnails) {
+         break;
+      }
+   }
+   if(!pp) {
+      return;
+   }
+
+   thumbnailsPending = 0;
+   for(layer = FIRST_LAYER; layer <= LAST_LAYER; layer++) {
+      for(np = nodes[layer]; np; np = np->next) {
+         ThumbnailType *tp;
+         if(np->parent == None || !(np->state.status & STAT_MAPPED)) {
+            continue;
+         }
+         if(np->state.status & STAT_NOPAGER) {
+            continue;
+         }
+         tp = FindThumbnail(np->parent);
+         if(!tp) {
+            const unsigned int index = np->parent % THUMBNAIL_HASH_SIZE;
+            tp = Allocate(sizeof(ThumbnailType));
+            tp->window = np->parent;
+            JXCompositeRedirectWindow(display, tp->window,
+                                      CompositeRedirectAutomatic);
+            tp->damage = JXDamageCreate(display, tp->window,
+                                        XDamageReportNonEmpty);
+            tp->pixmap = None;
+            tp->picture = None;
+            tp->width = 0;
+            tp->height = 0;
+            tp->updateTime.seconds = 0;
+            tp->updateTime.ms = 0;
+            tp->serial = 0;
+            tp->viewable = 0;
+            tp->damaged = 0;
+            tp->next = thumbnails[index];
+            thumbnails[index] = tp;
+         }
+         UpdateThumbnail(tp, np);
+      }
+   }
+}
+
+/** Update the thumbnail of a client. */
+void UpdateThumbnail(ThumbnailType *tp, const ClientNode *np)
+{
+   const unsigned int hiddenMask = STAT_HIDDEN | STAT_MINIMIZED | STAT_SHADED;
+   const char viewable = !(np->state.status & hiddenMask);
+   TimeType now;
+   int north, south, east, west;
+   int width, height;
+
+   if(!viewable) {
+      tp->viewable = 0;
+      return;
+   }
+
+   /* The frame gets a new pixmap when it is mapped or resized. */
+   GetBorderSize(&np->state, &north, &south, &east, &west);
+   width = np->width + east + west;
+   height = np->height + north + south;
+   if(!tp->viewable || tp->width != width || tp->height != height) {
+      XRenderPictFormat *fp = JXRenderFindVisualFormat(display, rootVisual);
+      if(tp->picture != None) {
+         JXRenderFreePicture(display, tp->picture);
+         JXFreePixmap(display, tp->pixmap);
+      }
+      tp->pixmap = JXCompositeNameWindowPixmap(display, tp->window);
+      tp->picture = JXRenderCreatePicture(display, tp->pixmap, fp, 0, NULL);
+      tp->width = width;
+      tp->height = height;
+      tp->viewable = 1;
+      tp->damaged = 1;
+      tp->updateTime.seconds = 0;
+      tp->updateTime.ms = 0;
+   }
+
+   /* Accept damage at most once per interval. */
+   if(tp->damaged) {
+      GetCurrentTime(&now);
+      if(GetTimeDifference(&tp->updateTime, &now) >= THUMBNAIL_INTERVAL) {
+         JXDamageSubtract(display, tp->damage, None, None);
+         tp->updateTime = now;
+         tp->serial += 1;
+         tp->damaged = 0;
       } else {
-         fillColor = COLOR_PAGER_FG;
+         thumbnailsPending = 1;
+      }
+   }
+}
+
+/** Release a thumbnail. */
+void DestroyThumbnail(ThumbnailType *tp)
+{
+   if(tp->picture != None) {
+      JXRenderFreePicture(display, tp->picture);
+      JXFreePixmap(display, tp->pixmap);
+   }
+   JXDamageDestroy(display, tp->damage);
+   JXCompositeUnredirectWindow(display, tp->window,
+                               CompositeRedirectAutomatic);
+   Release(tp);
+}
+
+/** Draw a scaled thumbnail inside a client outline on the pager.
+ * The transform is set up the same way as for scaled render icons.
+ */
+void DrawThumbnail(const PagerType *pp, const PagerShapeType *shape)
+{
+   const ClientNode *np = shape->client;
+   const ThumbnailType *tp = FindThumbnail(np->parent);
+   XRenderPictFormat *fp = JXRenderFindVisualFormat(display, rootVisual);
+   XRenderPictureAttributes pa;
+   XTransform xf;
+   Picture dest;
+   int north, south, east, west;
+
+   if(JUNLIKELY(shape->fullWidth <= 0 || shape->fullHeight <= 0)) {
+      return;
+   }
+
+   GetBorderSize(&np->state, &north, &south, &east, &west);
+
+   memset(&xf, 0, sizeof(xf));
+   xf.matrix[0][0] = XDoubleToFixed((double)np->width / shape->fullWidth);
+   xf.matrix[0][2] = XDoubleToFixed(west);
+   xf.matrix[1][1] = XDoubleToFixed((double)np->height / shape->fullHeight);
+   xf.matrix[1][2] = XDoubleToFixed(north);
+   xf.matrix[2][2] = XDoubleToFixed(1.0);
+   XRenderSetPictureTransform(display, tp->picture, &xf);
+   XRenderSetPictureFilter(display, tp->picture, FilterBilinear, NULL, 0);
+
+   pa.subwindow_mode = IncludeInferiors;
+   dest = JXRenderCreatePicture(display, pp->buffer, fp, CPSubwindowMode, &pa);
+   JXRenderComposite(display, PictOpSrc, tp->picture, None, dest,
+                     shape->sx + 1, shape->sy + 1, 0, 0,
+                     shape->x + 1, shape->y + 1,
+                     shape->width - 1, shape->height - 1);
+   JXRenderFreePicture(display, dest);
+
+   thumbnailsDrawn += 1;
+}
+
+/** Forget the thumbnail of a client. */
+void RemovePagerThumbnail(const ClientNode *np)
+{
+   ThumbnailType **prev;
+   if(np->parent == None) {
+      return;
+   }
+   prev = &thumbnails[np->parent % THUMBNAIL_HASH_SIZE];
+   while(*prev) {
+      ThumbnailType *tp = *prev;
+      if(tp->window == np->parent) {
+         *prev = tp->next;
+         DestroyThumbnail(tp);
+         RequirePagerUpdate();
+         return;
       }
-      JXSetForeground(display, rootGC, colors[fillColor]);
-      JXFillRectangle(display, pp->cp->pixmap, rootGC, x + 1, y + 1,
-                      width - 1, height - 1);
+      prev = &tp->next;
+   }
+}
+
+/** Handle a damage event for a client frame. */
+void HandlePagerDamage(const XDamageNotifyEvent *event)
+{
+   ThumbnailType *tp = FindThumbnail(event->drawable);
+   if(tp && !tp->damaged) {
+      tp->damaged = 1;
+      RequirePagerUpdate();
    }
+}
 
+/** Redraw pagers for damage that was held back by the rate limit
+ * and go back to thumbnails after the back off period.
+ */
+void SignalThumbnails(const TimeType *now, int x, int y, Window w,
+                      void *data)
+{
+   if(thumbnailsSuspended) {
+      if(GetTimeDifference(&suspendTime, now) >= THUMBNAIL_BACKOFF) {
+         thumbnailsSuspended = 0;
+         RequirePagerUpdate();
+      }
+   } else if(thumbnailsPending) {
+      RequirePagerUpdate();
+   }
 }
 
+#endif /* USE_XCOMPOSITE */
@@ -10,6 +10,7 @@
 #ifndef PAGER_H
 #define PAGER_H
 
+struct ClientNode;
 struct TrayComponentType;
 
 /*@{*/
@@ -21,12 +22,31 @@ void DestroyPager(void);
 
 /** Create a pager tray component.
  * @param labeled Set to label the pager.
+ * @param thumbnails Set to show window thumbnails.
  * @return A new pager tray component.
  */
-struct TrayComponentType *CreatePager(char labeled);
+struct TrayComponentType *CreatePager(char labeled, char thumbnails);
 
 /** Update pagers. */
 void UpdatePager(void);
 
+#ifdef USE_XCOMPOSITE
+
+/** Forget the thumbnail of a client that is being removed.
+ * @param np The client.
+ */
+void RemovePagerThumbnail(const struct ClientNode *np);
+
+/** Handle a damage event for a window shown on a pager.
+ * @param event The damage event.
+ */
+void HandlePagerDamage(const XDamageNotifyEvent *event);
+
+#else
+
+#define RemovePagerThumbnail( a )   (void)(0)
+
+#endif
+
 #endif /* PAGER_H */
 
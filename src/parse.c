@@ -33,6 +33,7 @@
 #include "desktop.h"
 #include "border.h"
 #include "default.h"
+#include "configcache.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -169,6 +170,7 @@ static const char *POPUP_ATTRIBUTE = "popup";
 static const char *CLIENTNAME_ATTRIBUTE = "showclient";
 static const char *CN_DELIMITERS_ATTRIBUTE = "delimiters";
 static const char *KILL_MENU_ATTRIBUTE = "showkill";
+static const char *THUMBNAILS_ATTRIBUTE = "thumbnails";
 
 static const char *FALSE_VALUE = "false";
 static const char *TRUE_VALUE = "true";
@@ -181,13 +183,44 @@ static const char * const CONFIG_FILES[] = {
 };
 static const unsigned CONFIG_FILE_COUNT = ARRAY_LENGTH(CONFIG_FILES);
 
+/** The parts of the configuration being loaded. */
+static ConfigPartType loadParts = CONFIG_ALL;
+
+/** Hashes of the parts of the configuration, used to detect changes. */
+static unsigned int groupHash = 0;
+static unsigned int trayHash = 0;
+static unsigned int otherHash = 0;
+
+/** Top-level tokens kept until their part is loaded. */
+typedef struct DeferredToken {
+   const TokenNode *tp;
+   struct DeferredToken *next;
+} DeferredToken;
+
+/** Token trees kept while tokens in them are deferred. */
+typedef struct KeptTokens {
+   TokenNode *tokens;
+   struct KeptTokens *next;
+} KeptTokens;
+
+/** The groups and trays parts deferred by the current parse. */
+static ConfigPartType deferParts = 0;
+static DeferredToken *deferredHead = NULL;
+static DeferredToken *deferredTail = NULL;
+static KeptTokens *keptTokens = NULL;
+
 static void ParseInternal(const char *config);
 static char ParseFile(const char *fileName, int depth);
 static TokenNode *TokenizeFile(const char *fileName);
 static TokenNode *TokenizePipe(const char *command, unsigned timeout_ms);
+static void ReleaseParsedTokens(TokenNode *tokens);
+static void DeferToken(const TokenNode *tp);
+static void FinishConfig(void);
 
 /* Misc. */
 static void Parse(const TokenNode *start, int depth);
+static ConfigPartType GetConfigPart(TokenType type);
+static unsigned int HashToken(const TokenNode *tp, unsigned int hash);
 static void ParseInclude(const TokenNode *tp, int depth);
 static void ParseDesktops(const TokenNode *tp);
 static void ParseDesktop(int desktop, const TokenNode *tp);
@@ -253,7 +286,7 @@ static void ParseFocusModel(const TokenNode *tp);
 static AlignmentType ParseTextAlignment(const TokenNode *tp);
 static void ParseDecorations(const TokenNode *tp, DecorationsType *deco);
 static void ParseGradient(const char *value, ColorType a, ColorType b);
-static char *FindAttribute(AttributeNode *ap, const char *name);
+static const char *FindAttribute(AttributeNode *ap, const char *name);
 static int ParseTokenValue(const StringMappingType *mapping, int count,
                            const TokenNode *tp, int def);
 static int ParseAttribute(const StringMappingType *mapping, int count,
@@ -274,12 +307,24 @@ void ParseInternal(const char *config)
 {
    TokenNode *tokens = Tokenize(config, "");
    Parse(tokens, 0);
-   ReleaseTokens(tokens);
+   ReleaseParsedTokens(tokens);
 }
 
 /** Parse the JWM configuration. */
-void ParseConfig(const char *fileName)
+ConfigPartType ParseConfig(const char *fileName, ConfigPartType parts)
 {
+   const unsigned int oldGroupHash = groupHash;
+   const unsigned int oldTrayHash = trayHash;
+   const unsigned int oldOtherHash = otherHash;
+   ConfigPartType changed;
+
+   Assert(!deferParts);
+   loadParts = parts;
+   deferParts = (CONFIG_GROUPS | CONFIG_TRAYS) & ~parts;
+   groupHash = 0;
+   trayHash = 0;
+   otherHash = 0;
+   OpenConfigCache();
    ParseInternal(BASE_CONFIG);
    if(fileName) {
       if(!ParseFile(fileName, 0)) {
@@ -298,8 +343,93 @@ void ParseConfig(const char *fileName)
       ParseInternal(DEFAULT_CONFIG);
    }
 ConfigFileFound:
-   ValidateTrayButtons();
-   ValidateKeys();
+   changed = 0;
+   if(groupHash != oldGroupHash) {
+      changed |= CONFIG_GROUPS;
+   }
+   if(trayHash != oldTrayHash) {
+      changed |= CONFIG_TRAYS;
+   }
+   if(otherHash != oldOtherHash) {
+      changed |= CONFIG_OTHER;
+   }
+   if(!deferParts) {
+      FinishConfig();
+   }
+   return changed;
+}
+
+/** Load parts of the configuration deferred by ParseConfig. */
+void LoadDeferredConfig(ConfigPartType parts)
+{
+   parts &= deferParts;
+   loadParts |= parts;
+   while(deferredHead) {
+      DeferredToken *dp = deferredHead->next;
+      const TokenNode *tp = deferredHead->tp;
+      if(GetConfigPart(tp->type) & parts) {
+         if(tp->type == TOK_GROUP) {
+            ParseGroup(tp);
+         } else {
+            ParseTray(tp);
+         }
+      }
+      Release(deferredHead);
+      deferredHead = dp;
+   }
+   deferredTail = NULL;
+   deferParts = 0;
+
+   while(keptTokens) {
+      KeptTokens *kp = keptTokens->next;
+      ReleaseTokens(keptTokens->tokens);
+      Release(keptTokens);
+      keptTokens = kp;
+   }
+
+   FinishConfig();
+}
+
+/** Validate the loaded configuration and close the cache. */
+void FinishConfig(void)
+{
+   if(loadParts & (CONFIG_BINDINGS | CONFIG_TRAYS)) {
+      ValidateTrayButtons();
+   }
+   if(loadParts & CONFIG_BINDINGS) {
+      ValidateKeys();
+   }
+   CloseConfigCache();
+}
+
+/** Release a parsed token tree.
+ * Trees are kept while parts are deferred since deferred tokens,
+ * the file names of included trees, and cached strings refer to them.
+ */
+void ReleaseParsedTokens(TokenNode *tokens)
+{
+   if(deferParts) {
+      KeptTokens *kp = Allocate(sizeof(KeptTokens));
+      kp->tokens = tokens;
+      kp->next = keptTokens;
+      keptTokens = kp;
+   } else {
+      ReleaseTokens(tokens);
+   }
+}
+
+/** Keep a top-level token to be loaded by LoadDeferredConfig. */
+void DeferToken(const TokenNode *tp)
+{
+   DeferredToken *dp = Allocate(sizeof(DeferredToken));
+   dp->tp = tp;
+   dp->next = NULL;
+   if(deferredTail) {
+      deferredTail->next = dp;
+   } else {
+      deferredHead = dp;
+   }
+   deferredTail = dp;
 }
 
 /**
@@ -323,7 +453,7 @@ char ParseFile(const char *fileName, int depth)
    }
 
    Parse(tokens, depth);
-   ReleaseTokens(tokens);
+   ReleaseParsedTokens(tokens);
 
    return 1;
 }
@@ -340,134 +470,141 @@ void Parse(const TokenNode *start, int depth)
 
    if(JLIKELY(start->type == TOK_JWM)) {
       for(tp = start->subnodeHead; tp; tp = tp->next) {
-         if(shouldReload) {
-            switch(tp->type) {
-            case TOK_ROOTMENU:
-               ParseRootMenu(tp);
-               break;
-            case TOK_INCLUDE:
-               ParseInclude(tp, depth);
-               break;
-            default:
-               break;
-            }
-         } else {
-            switch(tp->type) {
-            case TOK_DESKTOPS:
-               ParseDesktops(tp);
-               break;
-            case TOK_DOUBLECLICKSPEED:
-               settings.doubleClickSpeed = ParseUnsigned(tp, tp->value);
-               break;
-            case TOK_DOUBLECLICKDELTA:
-               settings.doubleClickDelta = ParseUnsigned(tp, tp->value);
-               break;
-            case TOK_FOCUSMODEL:
-               ParseFocusModel(tp);
-               break;
-            case TOK_GROUP:
-               ParseGroup(tp);
-               break;
-            case TOK_ICONPATH:
-               AddIconPath(tp->value);
-               break;
-            case TOK_INCLUDE:
-               ParseInclude(tp, depth);
-               break;
-            case TOK_KEY:
-               ParseKey(tp);
-               break;
-            case TOK_MOUSE:
-               ParseMouse(tp);
-               break;
-            case TOK_MENUSTYLE:
-               ParseMenuStyle(tp);
-               break;
-            case TOK_MOVEMODE:
-               ParseMoveMode(tp);
-               break;
-            case TOK_PAGERSTYLE:
-               ParsePagerStyle(tp);
-               break;
-            case TOK_POPUPSTYLE:
-               ParsePopupStyle(tp);
-               break;
-            case TOK_RESIZEMODE:
-               ParseResizeMode(tp);
-               break;
-            case TOK_RESTARTCOMMAND:
-               AddRestartCommand(tp->value);
-               break;
-            case TOK_ROOTMENU:
-               ParseRootMenu(tp);
-               break;
-            case TOK_SHUTDOWNCOMMAND:
-               AddShutdownCommand(tp->value);
-               break;
-            case TOK_SNAPMODE:
-               ParseSnapMode(tp);
-               break;
-            case TOK_STARTUPCOMMAND:
-               AddStartupCommand(tp->value);
-               break;
-            case TOK_TRAY:
-               ParseTray(tp);
-               break;
-            case TOK_TRAYSTYLE:
-               ParseTrayStyle(tp, FONT_TRAY, COLOR_TRAY_FG);
-               break;
-            case TOK_TASKLISTSTYLE:
-               ParseTrayStyle(tp, FONT_TASKLIST, COLOR_TASKLIST_FG);
-               break;
-            case TOK_TRAYBUTTONSTYLE:
-               ParseTrayStyle(tp, FONT_TRAYBUTTON, COLOR_TRAYBUTTON_FG);
-               break;
-            case TOK_CLOCKSTYLE:
-               ParseClockStyle(tp);
-               break;
-            case TOK_WINDOWSTYLE:
-               ParseWindowStyle(tp);
-               break;
-            case TOK_BUTTONCLOSE:
-               SetBorderIcon(BI_CLOSE, tp->value);
-               break;
-            case TOK_BUTTONCLOSEFOCUS:
-               SetBorderIcon(BI_CLOSE_FOCUS, tp->value);
-               break;
-            case TOK_BUTTONMAX:
-               SetBorderIcon(BI_MAX, tp->value);
-               break;
-            case TOK_BUTTONMAXACTIVE:
-               SetBorderIcon(BI_MAX_ACTIVE, tp->value);
-               break;
-            case TOK_BUTTONMAXACTIVEFOCUS:
-               SetBorderIcon(BI_MAX_ACTIVE_FOCUS, tp->value);
-               break;
-            case TOK_BUTTONMAXFOCUS:
-               SetBorderIcon(BI_MAX_FOCUS, tp->value);
-               break;
-            case TOK_BUTTONMIN:
-               SetBorderIcon(BI_MIN, tp->value);
-               break;
-            case TOK_BUTTONMINFOCUS:
-               SetBorderIcon(BI_MIN_FOCUS, tp->value);
-               break;
-            case TOK_BUTTONMENU:
-               SetBorderIcon(BI_MENU, tp->value);
-               break;
-            case TOK_BUTTONMENUFOCUS:
-               SetBorderIcon(BI_MENU_FOCUS, tp->value);
-               break;
-            case TOK_DEFAULTICON:
-               SetDefaultIcon(tp->value);
-               break;
-            case TOK_TITLEBUTTONORDER:
-               SetTitleButtonOrder(tp->value);
-               break;
-            default:
-               InvalidTag(tp, TOK_JWM);
-               break;
+         const ConfigPartType part = GetConfigPart(tp->type);
+         switch(part) {
+         case CONFIG_GROUPS:
+            groupHash = HashToken(tp, groupHash);
+            break;
+         case CONFIG_TRAYS:
+            trayHash = HashToken(tp, trayHash);
+            break;
+         case CONFIG_OTHER:
+            otherHash = HashToken(tp, otherHash);
+            break;
+         default:
+            break;
+         }
+         if(!(loadParts & part)) {
+            if(deferParts & part) {
+               DeferToken(tp);
             }
+            continue;
+         }
+         switch(tp->type) {
+         case TOK_DESKTOPS:
+            ParseDesktops(tp);
+            break;
+         case TOK_DOUBLECLICKSPEED:
+            settings.doubleClickSpeed = ParseUnsigned(tp, tp->value);
+            break;
+         case TOK_DOUBLECLICKDELTA:
+            settings.doubleClickDelta = ParseUnsigned(tp, tp->value);
+            break;
+         case TOK_FOCUSMODEL:
+            ParseFocusModel(tp);
+            break;
+         case TOK_GROUP:
+            ParseGroup(tp);
+            break;
+         case TOK_ICONPATH:
+            AddIconPath(tp->value);
+            break;
+         case TOK_INCLUDE:
+            ParseInclude(tp, depth);
+            break;
+         case TOK_KEY:
+            ParseKey(tp);
+            break;
+         case TOK_MOUSE:
+            ParseMouse(tp);
+            break;
+         case TOK_MENUSTYLE:
+            ParseMenuStyle(tp);
+            break;
+         case TOK_MOVEMODE:
+            ParseMoveMode(tp);
+            break;
+         case TOK_PAGERSTYLE:
+            ParsePagerStyle(tp);
+            break;
+         case TOK_POPUPSTYLE:
+            ParsePopupStyle(tp);
+            break;
+         case TOK_RESIZEMODE:
+            ParseResizeMode(tp);
+            break;
+         case TOK_RESTARTCOMMAND:
+            AddRestartCommand(tp->value);
+            break;
+         case TOK_ROOTMENU:
+            ParseRootMenu(tp);
+            break;
+         case TOK_SHUTDOWNCOMMAND:
+            AddShutdownCommand(tp->value);
+            break;
+         case TOK_SNAPMODE:
+            ParseSnapMode(tp);
+            break;
+         case TOK_STARTUPCOMMAND:
+            AddStartupCommand(tp->value);
+            break;
+         case TOK_TRAY:
+            ParseTray(tp);
+            break;
+         case TOK_TRAYSTYLE:
+            ParseTrayStyle(tp, FONT_TRAY, COLOR_TRAY_FG);
+            break;
+         case TOK_TASKLISTSTYLE:
+            ParseTrayStyle(tp, FONT_TASKLIST, COLOR_TASKLIST_FG);
+            break;
+         case TOK_TRAYBUTTONSTYLE:
+            ParseTrayStyle(tp, FONT_TRAYBUTTON, COLOR_TRAYBUTTON_FG);
+            break;
+         case TOK_CLOCKSTYLE:
+            ParseClockStyle(tp);
+            break;
+         case TOK_WINDOWSTYLE:
+            ParseWindowStyle(tp);
+            break;
+         case TOK_BUTTONCLOSE:
+            SetBorderIcon(BI_CLOSE, tp->value);
+            break;
+         case TOK_BUTTONCLOSEFOCUS:
+            SetBorderIcon(BI_CLOSE_FOCUS, tp->value);
+            break;
+         case TOK_BUTTONMAX:
+            SetBorderIcon(BI_MAX, tp->value);
+            break;
+         case TOK_BUTTONMAXACTIVE:
+            SetBorderIcon(BI_MAX_ACTIVE, tp->value);
+            break;
+         case TOK_BUTTONMAXACTIVEFOCUS:
+            SetBorderIcon(BI_MAX_ACTIVE_FOCUS, tp->value);
+            break;
+         case TOK_BUTTONMAXFOCUS:
+            SetBorderIcon(BI_MAX_FOCUS, tp->value);
+            break;
+         case TOK_BUTTONMIN:
+            SetBorderIcon(BI_MIN, tp->value);
+            break;
+         case TOK_BUTTONMINFOCUS:
+            SetBorderIcon(BI_MIN_FOCUS, tp->value);
+            break;
+         case TOK_BUTTONMENU:
+            SetBorderIcon(BI_MENU, tp->value);
+            break;
+         case TOK_BUTTONMENUFOCUS:
+            SetBorderIcon(BI_MENU_FOCUS, tp->value);
+            break;
+         case TOK_DEFAULTICON:
+            SetDefaultIcon(tp->value);
+            break;
+         case TOK_TITLEBUTTONORDER:
+            SetTitleButtonOrder(tp->value);
+            break;
+         default:
+            InvalidTag(tp, TOK_JWM);
+            break;
          }
       }
    } else {
@@ -476,6 +613,56 @@ void Parse(const TokenNode *start, int depth)
 
 }
 
+/** Determine the part of the configuration a top-level tag belongs to.
+ * Includes belong to every part and are not hashed themselves since
+ * their contents are. Bindings are always reloaded, so they are not
+ * hashed either.
+ */
+ConfigPartType GetConfigPart(TokenType type)
+{
+   switch(type) {
+   case TOK_INCLUDE:
+      return CONFIG_ALL;
+   case TOK_KEY:
+   case TOK_MOUSE:
+   case TOK_RESTARTCOMMAND:
+   case TOK_ROOTMENU:
+   case TOK_SHUTDOWNCOMMAND:
+   case TOK_STARTUPCOMMAND:
+      return CONFIG_BINDINGS;
+   case TOK_GROUP:
+      return CONFIG_GROUPS;
+   case TOK_TRAY:
+      return CONFIG_TRAYS;
+   default:
+      return CONFIG_OTHER;
+   }
+}
+
+/** Add a token and its children to a hash.
+ * Line numbers are ignored so that moving a tag does not count as a change.
+ */
+unsigned int HashToken(const TokenNode *tp, unsigned int hash)
+{
+   const AttributeNode *ap;
+   const TokenNode *np;
+
+   hash = hash * 31 + tp->type;
+   if(tp->value) {
+      hash = hash * 31 + HashString(tp->value);
+   }
+   for(ap = tp->attributes; ap; ap = ap->next) {
+      hash = hash * 31 + HashString(ap->name);
+      if(ap->value) {
+         hash = hash * 31 + HashString(ap->value);
+      }
+   }
+   for(np = tp->subnodeHead; np; np = np->next) {
+      hash = HashToken(np, hash);
+   }
+   return hash * 31 + 1;
+}
+
 /** Parse focus model. */
 void ParseFocusModel(const TokenNode *tp) {
    static const StringMappingType mapping[] = {
@@ -484,8 +671,21 @@ void ParseFocusModel(const TokenNode *tp) {
       { "sloppy",       FOCUS_SLOPPY         },
       { "sloppytitle",  FOCUS_SLOPPY_TITLE   }
    };
+   static const StringMappingType walkMapping[] = {
+      { "history",      WALK_HISTORY         },
+      { "stacking",     WALK_STACKING        }
+   };
+   static const StringMappingType scopeMapping[] = {
+      { "desktop",      WSCOPE_DESKTOP       },
+      { "screen",       WSCOPE_SCREEN        }
+   };
    settings.focusModel = ParseTokenValue(mapping, ARRAY_LENGTH(mapping), tp,
                                          settings.focusModel);
+   settings.walkOrder = ParseAttribute(walkMapping, ARRAY_LENGTH(walkMapping),
+                                       tp, "walk", settings.walkOrder);
+   settings.walkScope = ParseAttribute(scopeMapping,
+                                       ARRAY_LENGTH(scopeMapping), tp,
+                                       "walkscope", settings.walkScope);
 }
 
 /** Parse snap mode for moving windows. */
@@ -578,7 +778,7 @@ Menu *ParseMenu(const TokenNode *start)
 void ParseRootMenu(const TokenNode *start)
 {
    Menu *menu;
-   char *onroot;
+   const char *onroot;
    const char *value;
 
    menu = ParseMenu(start);
@@ -1123,7 +1323,7 @@ void ParseInclude(const TokenNode *tp, int depth)
       TokenNode *tokens = TokenizePipe(&tp->value[5], timeout_ms);
       if(JLIKELY(tokens)) {
          Parse(tokens, 0);
-         ReleaseTokens(tokens);
+         ReleaseParsedTokens(tokens);
       } else {
          ParseError(tp, _("could not process include: %s"), &tp->value[5]);
       }
@@ -1142,6 +1342,11 @@ void ParseDesktops(const TokenNode *tp) {
       { "off",       DBACKANDFORTH_OFF },
       { "on",        DBACKANDFORTH_ON  }
    };
+   static const StringMappingType hideMapping[] = {
+      { "iconic",    DHIDE_ICONIC   },
+      { "move",      DHIDE_MOVE     },
+      { "unmap",     DHIDE_UNMAP    }
+   };
    TokenNode *np;
    const char *width;
    const char *height;
@@ -1153,6 +1358,9 @@ void ParseDesktops(const TokenNode *tp) {
    backandforth = ParseAttribute(mapping, ARRAY_LENGTH(mapping), tp,
                                  "backandforth", DBACKANDFORTH_OFF);
    settings.desktopBackAndForth = backandforth;
+   settings.desktopHide = ParseAttribute(hideMapping,
+                                         ARRAY_LENGTH(hideMapping), tp,
+                                         "hide", DHIDE_UNMAP);
 
    width = FindAttribute(tp->attributes, WIDTH_ATTRIBUTE);
    if(width != NULL) {
@@ -1464,6 +1672,7 @@ void ParsePager(const TokenNode *tp, TrayType *tray)
    TrayComponentType *cp;
    const char *temp;
    int labeled;
+   int thumbnails;
 
    Assert(tp);
    Assert(tray);
@@ -1473,7 +1682,12 @@ void ParsePager(const TokenNode *tp, TrayType *tray)
    if(temp && !strcmp(temp, TRUE_VALUE)) {
       labeled = 1;
    }
-   cp = CreatePager(labeled);
+   thumbnails = 0;
+   temp = FindAttribute(tp->attributes, THUMBNAILS_ATTRIBUTE);
+   if(temp && !strcmp(temp, TRUE_VALUE)) {
+      thumbnails = 1;
+   }
+   cp = CreatePager(labeled, thumbnails);
    AddTrayComponent(tray, cp);
 
 }
@@ -1698,7 +1912,7 @@ void ParseDock(const TokenNode *tp, TrayType *tray) {
 
    TrayComponentType *cp;
    int width;
-   char *str;
+   const char *str;
 
    Assert(tp);
    Assert(tray);
@@ -1728,7 +1942,7 @@ void ParseSpacer(const TokenNode *tp, TrayType *tray) {
    TrayComponentType *cp;
    int width;
    int height;
-   char *str;
+   const char *str;
 
    Assert(tp);
    Assert(tray);
@@ -1831,12 +2045,14 @@ void ParsePopupStyle(const TokenNode *tp)
    };
    const TokenNode *np;
    const char *str;
+   char *enabled;
    char *tok;
 
-   tok = FindAttribute(tp->attributes, "enabled");
-   if(tok) {
+   /* Tokens are shared, so split a copy. */
+   enabled = CopyString(FindAttribute(tp->attributes, "enabled"));
+   if(enabled) {
       settings.popupMask = POPUP_NONE;
-      tok = strtok(tok, ",");
+      tok = strtok(enabled, ",");
       while(tok) {
          const int x = FindValue(enable_mapping,
                                  ARRAY_LENGTH(enable_mapping), tok);
@@ -1847,6 +2063,7 @@ void ParsePopupStyle(const TokenNode *tp)
          }
          tok = strtok(NULL, ",");
       }
+      Release(enabled);
    }
 
    str = FindAttribute(tp->attributes, "delay");
@@ -2070,7 +2287,7 @@ void ParseGradient(const char *value, ColorType a, ColorType b)
 }
 
 /** Find an attribute in a list of attributes. */
-char *FindAttribute(AttributeNode *ap, const char *name)
+const char *FindAttribute(AttributeNode *ap, const char *name)
 {
    while(ap) {
       if(!strcmp(name, ap->name)) {
@@ -2130,15 +2347,23 @@ TokenNode *TokenizeFile(const char *fileName)
    ExpandPath(&path);
 
    int fd = open(path, O_RDONLY);
-   Release(path);
-
    if(fd < 0) {
+      Release(path);
       return NULL;
    }
    if(JUNLIKELY(fstat(fd, &sbuf) == -1)) {
+      Release(path);
       close(fd);
       return NULL;
    }
+
+   tokens = LoadCachedConfig(path, &sbuf, fileName);
+   if(tokens) {
+      Release(path);
+      close(fd);
+      return tokens;
+   }
+
    buffer = Allocate(sbuf.st_size + 1);
    offset = 0;
    while(offset < sbuf.st_size) {
@@ -2150,7 +2375,11 @@ TokenNode *TokenizeFile(const char *fileName)
    }
    buffer[offset] = 0;
    tokens = Tokenize(buffer, fileName);
+   if(offset == sbuf.st_size) {
+      CacheConfig(path, &sbuf, tokens);
+   }
    Release(buffer);
+   Release(path);
    close(fd);
    return tokens;
 }
@@ -2213,7 +2442,7 @@ unsigned ParseUnsigned(const TokenNode *tp, const char *str)
 /** Parse a timeout attribute. */
 unsigned ParseTimeout(const TokenNode *tp, unsigned timeout_ms)
 {
-   char *temp = FindAttribute(tp->attributes, TIMEOUT_ATTRIBUTE);
+   const char *temp = FindAttribute(tp->attributes, TIMEOUT_ATTRIBUTE);
    if(temp) {
       const unsigned ms = ParseUnsigned(tp, temp);
       timeout_ms = ms == 0 ? timeout_ms : ms;
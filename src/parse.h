@@ -12,10 +12,28 @@
 
 struct Menu;
 
+/** Parts of the configuration that can be loaded separately. */
+typedef unsigned char ConfigPartType;
+#define CONFIG_BINDINGS 0x01  /**< Root menus, bindings, and commands. */
+#define CONFIG_GROUPS   0x02  /**< Group options. */
+#define CONFIG_TRAYS    0x04  /**< Tray layout. */
+#define CONFIG_OTHER    0x08  /**< Everything else. */
+#define CONFIG_ALL      0x0F
+
 /** Parse a configuration file.
+ * Groups and trays not in parts are kept for LoadDeferredConfig,
+ * which must be called before the next parse.
  * @param fileName The user-specified config file to parse.
+ * @param parts The parts of the configuration to load.
+ * @return The groups, trays, and other parts of the configuration
+ *         that changed since the last parse.
+ */
+ConfigPartType ParseConfig(const char *fileName, ConfigPartType parts);
+
+/** Load groups and trays deferred by the last call to ParseConfig.
+ * @param parts The deferred parts to load, possibly none.
  */
-void ParseConfig(const char *fileName);
+void LoadDeferredConfig(ConfigPartType parts);
 
 /** Parse a dynamic menu.
  * @param timeout_ms The timeout in milliseconds.
@@ -40,6 +40,9 @@ void RemoveClientStrut(ClientNode *np);
  */
 void ReadClientStrut(ClientNode *np);
 
+/** Update _NET_WORKAREA, for example after the trays change. */
+void SetWorkarea(void);
+
 /** Place a client on the screen.
  * @param np The client to place.
  * @param alreadyMapped 1 if already mapped, 0 if unmapped.
@@ -19,6 +19,7 @@
 #include "settings.h"
 #include "event.h"
 #include "hint.h"
+#include "winmap.h"
 
 typedef struct PopupType {
    int x, y;   /* The coordinates of the upper-left corner of the popup. */
@@ -35,6 +36,7 @@ typedef struct PopupType {
 static PopupType popup;
 
 static void MeasurePopupText();
+static char ProcessPopupEvent(void *data, const XEvent *event);
 static void SignalPopup(const TimeType *now, int x, int y, Window w,
                         void *data);
 
@@ -56,6 +58,7 @@ void ShutdownPopup(void)
       popup.text = NULL;
    }
    if(popup.window != None) {
+      UnregisterWindow(popup.window);
       JXDestroyWindow(display, popup.window);
       JXFreePixmap(display, popup.pmap);
       popup.window = None;
@@ -171,6 +174,9 @@ void ShowPopup(int x, int y, const char *text,
                                     CopyFromParent, attrMask, &attr);
       SetAtomAtom(popup.window, ATOM_NET_WM_WINDOW_TYPE,
                   ATOM_NET_WM_WINDOW_TYPE_NOTIFICATION);
+      RegisterWindowHandler(popup.window, OWNER_POPUP, NULL,
+                            ExposureMask | PointerMotionMask,
+                            ProcessPopupEvent);
       JXMapRaised(display, popup.window);
 
    } else {
@@ -209,6 +215,7 @@ void SignalPopup(const TimeType *now, int x, int y, Window w, void *data)
    if(popup.window != None) {
       if(popup.mw != w ||
          abs(popup.mx - x) > 0 || abs(popup.my - y) > 0) {
+         UnregisterWindow(popup.window);
          JXDestroyWindow(display, popup.window);
          JXFreePixmap(display, popup.pmap);
          popup.window = None;
@@ -217,18 +224,17 @@ void SignalPopup(const TimeType *now, int x, int y, Window w, void *data)
 }
 
 /** Process an event on a popup window. */
-char ProcessPopupEvent(const XEvent *event)
+char ProcessPopupEvent(void *data, const XEvent *event)
 {
-   if(popup.window != None && event->xany.window == popup.window) {
-      if(event->type == Expose && event->xexpose.count == 0) {
-         JXCopyArea(display, popup.pmap, popup.window, rootGC,
-                    0, 0, popup.width, popup.height, 0, 0);
-      } else if(event->type == MotionNotify) {
-         JXDestroyWindow(display, popup.window);
-         JXFreePixmap(display, popup.pmap);
-         popup.window = None;
-      }
-      return 1;
+   Assert(event->xany.window == popup.window);
+   if(event->type == Expose && event->xexpose.count == 0) {
+      JXCopyArea(display, popup.pmap, popup.window, rootGC,
+                 0, 0, popup.width, popup.height, 0, 0);
+   } else if(event->type == MotionNotify) {
+      UnregisterWindow(popup.window);
+      JXDestroyWindow(display, popup.window);
+      JXFreePixmap(display, popup.pmap);
+      popup.window = None;
    }
-   return 0;
+   return 1;
 }
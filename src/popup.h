@@ -28,11 +28,5 @@ void ShutdownPopup(void);
 void ShowPopup(int x, int y, const char *text,
                const PopupMaskType context);
 
-/** Process a popup event.
- * @param event The event to process.
- * @return 1 if handled, 0 otherwise.
- */
-char ProcessPopupEvent(const XEvent *event);
-
 #endif /* POPUP_H */
 
@@ -19,6 +19,16 @@
 #include "parse.h"
 #include "settings.h"
 #include "desktop.h"
+#include "binding.h"
+#include "group.h"
+#include "place.h"
+#include "tray.h"
+#include "traybutton.h"
+#include "taskbar.h"
+#include "pager.h"
+#include "clock.h"
+#include "dock.h"
+#include "swallow.h"
 
 /** Number of root menus to support. */
 #define ROOT_MENU_COUNT 36
@@ -29,6 +39,10 @@ static void ExitHandler(ClientNode *np);
 
 static void RunRootCommand(MenuAction *action, unsigned button);
 
+static void ResetGroups(void);
+static void ResetTrays(void);
+static void StartTrays(void);
+
 /** Initialize root menu data. */
 void InitializeRootMenu(void)
 {
@@ -228,20 +242,108 @@ void Exit(char confirm)
    }
 }
 
-/** Reload the menu. */
-void ReloadMenu(void)
+/** Reload the configuration. */
+void ReloadConfig(void)
 {
+   ConfigPartType changed;
+   ConfigPartType parts;
+
    shouldReload = 1;
    if(!menuShown) {
+      ShutdownBindings();
       ShutdownRootMenu();
+      DestroyBindings();
       DestroyRootMenu();
+      DestroyCommands();
+      InitializeBindings();
       InitializeRootMenu();
-      ParseConfig(configPath);
+      InitializeCommands();
+      changed = ParseConfig(configPath, CONFIG_BINDINGS);
+
+      /* Apply changed groups and trays from the same parse. */
+      parts = 0;
+      if(!(changed & CONFIG_OTHER)) {
+         parts = changed & (CONFIG_GROUPS | CONFIG_TRAYS);
+      }
+      if(parts & CONFIG_GROUPS) {
+         ResetGroups();
+      }
+      if(parts & CONFIG_TRAYS) {
+         ResetTrays();
+      }
+      LoadDeferredConfig(parts);
+      if(parts & CONFIG_GROUPS) {
+         StartupGroups();
+      }
+      if(parts & CONFIG_TRAYS) {
+         StartTrays();
+      }
+      StartupBindings();
       StartupRootMenu();
       shouldReload = 0;
+      if(changed & CONFIG_OTHER) {
+         Restart();
+      }
    }
 }
 
+/** Clear the group options before loading new ones.
+ * The new options apply to windows mapped from now on.
+ */
+void ResetGroups(void)
+{
+   ShutdownGroups();
+   DestroyGroups();
+   InitializeGroups();
+}
+
+/** Remove the trays and their components before loading new ones.
+ * This must happen while bindings are shut down since keys are
+ * grabbed on the tray windows.
+ */
+void ResetTrays(void)
+{
+   ShutdownSwallow();
+   ShutdownPager();
+   ShutdownDock();
+   ShutdownTray();
+   ShutdownTrayButtons();
+   ShutdownTaskBar();
+   ShutdownClock();
+
+   DestroyClock();
+   DestroyDock();
+   DestroyPager();
+   DestroySwallow();
+   DestroyTaskBar();
+   DestroyTray();
+   DestroyTrayButtons();
+
+   /* The task bar is not initialized again since its list of
+    * task entries tracks the managed clients. */
+   InitializeClock();
+   InitializeDock();
+   InitializePager();
+   InitializeSwallow();
+   InitializeTray();
+   InitializeTrayButtons();
+}
+
+/** Start the trays loaded after ResetTrays. */
+void StartTrays(void)
+{
+   StartupPager();
+   StartupClock();
+   StartupTaskBar();
+   StartupTrayButtons();
+   StartupDock();
+   StartupTray();
+   StartupSwallow();
+
+   SetWorkarea();
+   RestackClients();
+}
+
 /** Root menu callback. */
 void RunRootCommand(MenuAction *action, unsigned button)
 {
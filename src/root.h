@@ -64,8 +64,12 @@ void Restart(void);
  */
 void Exit(char confirm);
 
-/** Reload the menu. */
-void ReloadMenu(void);
+/** Reload the configuration.
+ * Root menus, bindings, and commands are replaced in place. Groups and
+ * trays are rebuilt in place if they changed. JWM is restarted if any
+ * other part of the configuration changed.
+ */
+void ReloadConfig(void);
 
 #endif /* ROOT_H */
 
@@ -55,6 +55,9 @@ void InitializeSettings(void)
    settings.desktopWidth = 4;
    settings.desktopHeight = 1;
    settings.desktopBackAndForth = DBACKANDFORTH_OFF;
+   settings.desktopHide = DHIDE_UNMAP;
+   settings.walkOrder = WALK_STACKING;
+   settings.walkScope = WSCOPE_DESKTOP;
    settings.menuOpacity = UINT_MAX;
    settings.windowDecorations = DECO_FLAT;
    settings.trayDecorations = DECO_FLAT;
@@ -84,6 +84,22 @@ typedef unsigned char DesktopBackAndForthType;
 #define DBACKANDFORTH_OFF 0 /**< No back and forth */
 #define DBACKANDFORTH_ON  1 /**< Enable back and forth */
 
+/** How windows on other desktops are hidden. */
+typedef unsigned char DesktopHideType;
+#define DHIDE_UNMAP     0  /**< Unmap windows. */
+#define DHIDE_MOVE      1  /**< Keep windows mapped but off-screen. */
+#define DHIDE_ICONIC    2  /**< Like DHIDE_MOVE, but set IconicState. */
+
+/** Order in which windows are visited when walking the window stack. */
+typedef unsigned char WalkOrderType;
+#define WALK_STACKING   0  /**< Stacking order. */
+#define WALK_HISTORY    1  /**< Most recently focused first. */
+
+/** Windows visited when walking the window stack. */
+typedef unsigned char WalkScopeType;
+#define WSCOPE_DESKTOP  0  /**< Windows on the current desktop. */
+#define WSCOPE_SCREEN   1  /**< Windows on the current desktop and screen. */
+
 /** Maximum number of title bar components
  * For now, we allow each component to be used twice. */
 #define TBC_COUNT       9
@@ -127,6 +143,9 @@ typedef struct {
    char clientNameDelimiters[2];
    char showKillMenuItem;
    DesktopBackAndForthType desktopBackAndForth;
+   DesktopHideType desktopHide;
+   WalkOrderType walkOrder;
+   WalkScopeType walkScope;
 } Settings;
 
 extern Settings settings;
@@ -16,6 +16,7 @@
 #include "color.h"
 #include "client.h"
 #include "misc.h"
+#include "winmap.h"
 
 typedef struct SwallowNode {
 
@@ -34,6 +35,7 @@ typedef struct SwallowNode {
 static SwallowNode *pendingNodes = NULL;
 static SwallowNode *swallowNodes = NULL;
 
+static char ProcessSwallowEvent(void *data, const XEvent *event);
 static void ReleaseNodes(SwallowNode *nodes);
 static void Destroy(TrayComponentType *cp);
 static void Resize(TrayComponentType *cp);
@@ -119,48 +121,44 @@ TrayComponentType *CreateSwallow(const char *name, const char *command,
 }
 
 /** Process an event on a swallowed window. */
-char ProcessSwallowEvent(const XEvent *event)
+char ProcessSwallowEvent(void *data, const XEvent *event)
 {
 
-   SwallowNode *np;
+   TrayComponentType *cp = (TrayComponentType*)data;
+   SwallowNode *np = (SwallowNode*)cp->object;
    int width, height;
 
-   for(np = swallowNodes; np; np = np->next) {
-      if(event->xany.window == np->cp->window) {
-         switch(event->type) {
-         case DestroyNotify:
-            np->cp->window = None;
-            np->cp->requestedWidth = 1;
-            np->cp->requestedHeight = 1;
-            ResizeTray(np->cp->tray);
-            break;
-         case ResizeRequest:
-            np->cp->requestedWidth
-               = event->xresizerequest.width + np->border * 2;
-            np->cp->requestedHeight
-               = event->xresizerequest.height + np->border * 2;
-            ResizeTray(np->cp->tray);
-            break;
-         case ConfigureNotify:
-            /* I don't think this should be necessary, but somehow
-             * resize requests slip by sometimes... */
-            width = event->xconfigure.width + np->border * 2;
-            height = event->xconfigure.height + np->border * 2;
-            if(   width != np->cp->requestedWidth
-               && height != np->cp->requestedHeight) {
-               np->cp->requestedWidth = width;
-               np->cp->requestedHeight = height;
-               ResizeTray(np->cp->tray);
-            }
-            break;
-         default:
-            break;
-         }
-         return 1;
+   Assert(event->xany.window == cp->window);
+
+   switch(event->type) {
+   case DestroyNotify:
+      UnregisterWindow(cp->window);
+      cp->window = None;
+      cp->requestedWidth = 1;
+      cp->requestedHeight = 1;
+      ResizeTrayComponent(cp);
+      break;
+   case ResizeRequest:
+      cp->requestedWidth = event->xresizerequest.width + np->border * 2;
+      cp->requestedHeight = event->xresizerequest.height + np->border * 2;
+      ResizeTrayComponent(cp);
+      break;
+   case ConfigureNotify:
+      /* I don't think this should be necessary, but somehow
+       * resize requests slip by sometimes... */
+      width = event->xconfigure.width + np->border * 2;
+      height = event->xconfigure.height + np->border * 2;
+      if(   width != cp->requestedWidth
+         && height != cp->requestedHeight) {
+         cp->requestedWidth = width;
+         cp->requestedHeight = height;
+         ResizeTrayComponent(cp);
       }
+      break;
+   default:
+      break;
    }
-
-   return 0;
+   return 1;
 
 }
 
@@ -186,6 +184,7 @@ void Destroy(TrayComponentType *cp)
    /* Destroy the window if there is one. */
    if(cp->window) {
 
+      UnregisterWindow(cp->window);
       JXReparentWindow(display, cp->window, rootWindow, 0, 0);
       JXRemoveFromSaveSet(display, cp->window);
 
@@ -241,6 +240,9 @@ char CheckSwallowMap(Window win)
                           np->cp->tray->window, 0, 0);
          JXMapRaised(display, win);
          np->cp->window = win;
+         RegisterWindowHandler(win, OWNER_SWALLOW, np->cp,
+                               StructureNotifyMask | ResizeRedirectMask,
+                               ProcessSwallowEvent);
 
          /* Remove this node from the pendingNodes list and place it
           * on the swallowNodes list. */
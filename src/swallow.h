@@ -33,12 +33,6 @@ struct TrayComponentType *CreateSwallow(const char *name,
  */
 char CheckSwallowMap(Window win);
 
-/** Process an event on a swallowed window.
- * @param event The event to process.
- * @return 1 if the event was for a swallowed window, 0 if not.
- */
-char ProcessSwallowEvent(const XEvent *event);
-
 /** Determine if there are swallow processes pending.
  * @return 1 if there are still pending swallow processes, 0 otherwise.
  */
@@ -27,6 +27,17 @@
 #include "misc.h"
 #include "desktop.h"
 
+/** Render state of a task bar button.
+ * The button position is determined by its index and the item size.
+ */
+typedef struct TaskButtonState {
+   const ClientNode *client;  /**< First client of the entry. */
+   IconNode *icon;            /**< Icon drawn on the button. */
+   char *text;                /**< Label drawn on the button. */
+   ButtonType type;           /**< Button type. */
+   char valid;                /**< Set if this state matches the pixmap. */
+} TaskButtonState;
+
 typedef struct TaskBarType {
 
    TrayComponentType *cp;
@@ -41,6 +52,14 @@ typedef struct TaskBarType {
    LabelPosition labelPos;
 
    Pixmap buffer;
+   Pixmap background;         /**< Cached tray background. */
+
+   TaskButtonState *buttons;  /**< State of each button drawn. */
+   unsigned buttonCount;      /**< Number of buttons drawn. */
+   unsigned buttonMax;        /**< Size of the buttons array. */
+   int renderWidth;           /**< Item width of the drawn buttons. */
+   int renderHeight;          /**< Item height of the drawn buttons. */
+   char invalid;              /**< Set to redraw all buttons. */
 
    TimeType mouseTime;
    int mousex, mousey;
@@ -68,7 +87,12 @@ static void ComputeItemSize(TaskBarType *tp);
 static char ShouldShowEntry(const TaskEntry *tp);
 static char ShouldFocusEntry(const TaskEntry *tp);
 static TaskEntry *GetEntry(TaskBarType *bar, int x, int y);
-static void Render(const TaskBarType *bp);
+static void Render(TaskBarType *bp);
+static char UpdateButtonState(TaskButtonState *sp, const ClientNode *client,
+                              IconNode *icon, const char *text,
+                              ButtonType type);
+static void ClearButtonStates(TaskBarType *bp);
+static void CreateBuffers(TaskBarType *bp);
 static void ShowClientList(TaskBarType *bar, TaskEntry *tp);
 static void RunTaskBarCommand(MenuAction *action, unsigned button);
 
@@ -99,6 +123,8 @@ void ShutdownTaskBar(void)
    TaskBarType *bp;
    for(bp = bars; bp; bp = bp->next) {
       JXFreePixmap(display, bp->buffer);
+      JXFreePixmap(display, bp->background);
+      ClearButtonStates(bp);
    }
 }
 
@@ -109,6 +135,9 @@ void DestroyTaskBar(void)
    while(bars) {
       bp = bars->next;
       UnregisterCallback(SignalTaskbar, bars);
+      if(bars->buttons) {
+         Release(bars->buttons);
+      }
       Release(bars);
       bars = bp;
    }
@@ -135,6 +164,14 @@ TrayComponentType *CreateTaskBar()
    tp->mousey = -settings.doubleClickDelta;
    tp->mouseTime.seconds = 0;
    tp->mouseTime.ms = 0;
+   tp->buffer = None;
+   tp->background = None;
+   tp->buttons = NULL;
+   tp->buttonCount = 0;
+   tp->buttonMax = 0;
+   tp->renderWidth = 0;
+   tp->renderHeight = 0;
+   tp->invalid = 1;
 
    cp = CreateTrayComponent();
    cp->object = tp;
@@ -171,10 +208,14 @@ void SetSize(TrayComponentType *cp, int width, int height)
 void Create(TrayComponentType *cp)
 {
    TaskBarType *tp = (TaskBarType*)cp->object;
-   cp->pixmap = JXCreatePixmap(display, rootWindow, cp->width, cp->height,
-                               rootDepth);
-   tp->buffer = cp->pixmap;
-   ClearTrayDrawable(cp);
+   CreateBuffers(tp);
+   if(tp->layout == LAYOUT_HORIZONTAL) {
+      RequestIconSize(cp->height - BUTTON_BORDER * 2);
+   } else if(tp->userHeight > 0) {
+      RequestIconSize(tp->userHeight - BUTTON_BORDER * 2);
+   } else {
+      RequestIconSize(GetStringHeight(FONT_TASKLIST) + 12 - BUTTON_BORDER * 2);
+   }
 }
 
 /** Resize a task bar tray component. */
@@ -183,11 +224,27 @@ void Resize(TrayComponentType *cp)
    TaskBarType *tp = (TaskBarType*)cp->object;
    if(tp->buffer != None) {
       JXFreePixmap(display, tp->buffer);
+      JXFreePixmap(display, tp->background);
    }
+   CreateBuffers(tp);
+}
+
+/** Create the pixmaps for a task bar.
+ * The tray background is drawn once and kept so that it can be restored
+ * under buttons that change.
+ */
+void CreateBuffers(TaskBarType *bp)
+{
+   TrayComponentType *cp = bp->cp;
    cp->pixmap = JXCreatePixmap(display, rootWindow, cp->width, cp->height,
                                rootDepth);
-   tp->buffer = cp->pixmap;
+   bp->buffer = cp->pixmap;
    ClearTrayDrawable(cp);
+   bp->background = JXCreatePixmap(display, rootWindow,
+                                   cp->width, cp->height, rootDepth);
+   JXCopyArea(display, bp->buffer, bp->background, rootGC, 0, 0,
+              cp->width, cp->height, 0, 0);
+   bp->invalid = 1;
 }
 
 /** Count the number of items that should be shown in the task bar. */
@@ -758,7 +815,7 @@ void UpdateTaskBar(void)
          }
          bp->cp->requestedHeight = Max(1, bp->cp->requestedHeight);
          if(lastHeight != bp->cp->requestedHeight) {
-            ResizeTray(bp->cp->tray);
+            ResizeTrayComponent(bp->cp);
          }
       }
       ComputeItemSize(bp);
@@ -792,25 +849,36 @@ void SignalTaskbar(const TimeType *now, int x, int y, Window w, void *data)
 
 }
 
-/** Draw a specific task bar. */
-void Render(const TaskBarType *bp)
+/** Draw a specific task bar.
+ * Only buttons whose contents changed since the last call are redrawn
+ * and copied to the tray.
+ */
+void Render(TaskBarType *bp)
 {
+   TrayComponentType *cp = bp->cp;
    TaskEntry *tp;
    char *displayName;
    ButtonNode button;
+   unsigned index;
    int x, y;
 
    if(JUNLIKELY(shouldExit)) {
       return;
    }
 
-   ClearTrayDrawable(bp->cp);
-   if(!taskEntries) {
-      UpdateSpecificTray(bp->cp->tray, bp->cp);
-      return;
+   /* A new item size moves every button, so start over. */
+   if(bp->itemWidth != bp->renderWidth || bp->itemHeight != bp->renderHeight) {
+      bp->renderWidth = bp->itemWidth;
+      bp->renderHeight = bp->itemHeight;
+      bp->invalid = 1;
+   }
+   if(bp->invalid) {
+      JXCopyArea(display, bp->background, bp->buffer, rootGC, 0, 0,
+                 cp->width, cp->height, 0, 0);
+      ClearButtonStates(bp);
    }
 
-   ResetButton(&button, bp->cp->pixmap);
+   ResetButton(&button, cp->pixmap);
    button.border = settings.taskListDecorations == DECO_MOTIF;
    button.font = FONT_TASKLIST;
    button.height = bp->itemHeight;
@@ -820,6 +888,7 @@ void Render(const TaskBarType *bp)
 
    x = 0;
    y = 0;
+   index = 0;
    for(tp = taskEntries; tp; tp = tp->next) {
 
       if(!ShouldShowEntry(tp)) {
@@ -827,15 +896,15 @@ void Render(const TaskBarType *bp)
       }
 
       /* Check for an active or urgent window and count clients. */
-      ClientEntry *cp;
+      ClientEntry *ep;
       unsigned clientCount = 0;
       button.type = BUTTON_TASK;
-      for(cp = tp->clients; cp; cp = cp->next) {
-         if(ShouldFocus(cp->client, 0)) {
-            const char flash = (cp->client->state.status & STAT_FLASH) != 0;
-            const char active = (cp->client->state.status & STAT_ACTIVE)
-               && IsClientOnCurrentDesktop(cp->client);
-            const char minimized = (cp->client->state.status & STAT_MINIMIZED);
+      for(ep = tp->clients; ep; ep = ep->next) {
+         if(ShouldFocus(ep->client, 0)) {
+            const char flash = (ep->client->state.status & STAT_FLASH) != 0;
+            const char active = (ep->client->state.status & STAT_ACTIVE)
+               && IsClientOnCurrentDesktop(ep->client);
+            const char minimized = (ep->client->state.status & STAT_MINIMIZED);
             if(flash || active) {
                if(button.type != BUTTON_TASK_ACTIVE) {
                   button.type = BUTTON_TASK_ACTIVE;
@@ -858,6 +927,7 @@ void Render(const TaskBarType *bp)
          button.icon = tp->clients->client->icon;
       }
       displayName = NULL;
+      button.text = NULL;
       if(bp->labeled) {
          if(tp->clients->client->className && settings.groupTasks) {
             if(clientCount != 1) {
@@ -873,12 +943,35 @@ void Render(const TaskBarType *bp)
             button.text = tp->clients->client->name;
          }
       }
-      DrawButton(&button);
+
+      /* Grow the state array if needed. */
+      if(index >= bp->buttonMax) {
+         bp->buttonMax = bp->buttonMax ? bp->buttonMax * 2 : 16;
+         bp->buttons = Reallocate(bp->buttons,
+                                  bp->buttonMax * sizeof(TaskButtonState));
+      }
+      if(index >= bp->buttonCount) {
+         bp->buttons[index].text = NULL;
+         bp->buttons[index].valid = 0;
+         bp->buttonCount = index + 1;
+      }
+
+      if(UpdateButtonState(&bp->buttons[index], tp->clients->client,
+                           button.icon, button.text, button.type)) {
+         JXCopyArea(display, bp->background, bp->buffer, rootGC,
+                    x, y, bp->itemWidth, bp->itemHeight, x, y);
+         DrawButton(&button);
+         if(!bp->invalid) {
+            UpdateSpecificTrayArea(cp->tray, cp, x, y,
+                                   bp->itemWidth, bp->itemHeight);
+         }
+      }
 
       if(displayName) {
          Release(displayName);
       }
 
+      index += 1;
       if(bp->layout == LAYOUT_HORIZONTAL) {
          x += bp->itemWidth;
       } else {
@@ -886,8 +979,86 @@ void Render(const TaskBarType *bp)
       }
    }
 
-   UpdateSpecificTray(bp->cp->tray, bp->cp);
+   /* Restore the background where buttons were removed. */
+   if(index < bp->buttonCount) {
+      int width, height;
+      if(bp->layout == LAYOUT_HORIZONTAL) {
+         width = (bp->buttonCount - index) * bp->itemWidth;
+         height = bp->itemHeight;
+      } else {
+         width = bp->itemWidth;
+         height = (bp->buttonCount - index) * bp->itemHeight;
+      }
+      JXCopyArea(display, bp->background, bp->buffer, rootGC,
+                 x, y, width, height, x, y);
+      if(!bp->invalid) {
+         UpdateSpecificTrayArea(cp->tray, cp, x, y, width, height);
+      }
+      while(bp->buttonCount > index) {
+         bp->buttonCount -= 1;
+         if(bp->buttons[bp->buttonCount].text) {
+            Release(bp->buttons[bp->buttonCount].text);
+         }
+      }
+   }
+
+   if(bp->invalid) {
+      UpdateSpecificTray(cp->tray, cp);
+      bp->invalid = 0;
+   }
+
+}
+
+/** Update the render state of a button.
+ * @return 1 if the button needs to be redrawn, 0 otherwise.
+ */
+char UpdateButtonState(TaskButtonState *sp, const ClientNode *client,
+                       IconNode *icon, const char *text, ButtonType type)
+{
+   if(sp->valid && sp->client == client && sp->icon == icon
+      && sp->type == type) {
+      if(sp->text == NULL && text == NULL) {
+         return 0;
+      }
+      if(sp->text && text && !strcmp(sp->text, text)) {
+         return 0;
+      }
+   }
+   if(sp->text) {
+      Release(sp->text);
+   }
+   sp->client = client;
+   sp->icon = icon;
+   sp->text = CopyString(text);
+   sp->type = type;
+   sp->valid = 1;
+   return 1;
+}
+
+/** Forget the render state of all buttons on a task bar. */
+void ClearButtonStates(TaskBarType *bp)
+{
+   while(bp->buttonCount > 0) {
+      bp->buttonCount -= 1;
+      if(bp->buttons[bp->buttonCount].text) {
+         Release(bp->buttons[bp->buttonCount].text);
+      }
+   }
+}
 
+/** Redraw the task bar buttons for a client with a new icon. */
+void InvalidateTaskBarIcon(const ClientNode *np)
+{
+   TaskBarType *bp;
+   unsigned i;
+   for(bp = bars; bp; bp = bp->next) {
+      for(i = 0; i < bp->buttonCount; i++) {
+         if(bp->buttons[i].client == np) {
+            bp->buttons[i].valid = 0;
+         }
+      }
+   }
+   RequireTaskUpdate();
 }
 
 /** Focus the next client in the task bar. */
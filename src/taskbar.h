@@ -36,6 +36,12 @@ void RemoveClientFromTaskBar(struct ClientNode *np);
 /** Update all task bars. */
 void UpdateTaskBar(void);
 
+/** Redraw task bar buttons showing the icon of a client.
+ * This is needed when the icon of a client is reloaded.
+ * @param np The client.
+ */
+void InvalidateTaskBarIcon(const struct ClientNode *np);
+
 /** Focus the client in the task bar.
  * @param n The window position in the taskbar.
  */
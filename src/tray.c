@@ -22,6 +22,7 @@
 #include "client.h"
 #include "misc.h"
 #include "hint.h"
+#include "winmap.h"
 
 #define DEFAULT_TRAY_WIDTH 32
 #define DEFAULT_TRAY_HEIGHT 32
@@ -31,6 +32,7 @@
 static TrayType *trays;
 static unsigned int trayCount;
 
+static char ProcessTrayEvent(void *data, const XEvent *event);
 static void HandleTrayExpose(TrayType *tp, const XExposeEvent *event);
 static void HandleTrayEnterNotify(TrayType *tp, const XCrossingEvent *event);
 
@@ -40,6 +42,9 @@ static void HandleTrayButtonRelease(TrayType *tp, const XButtonEvent *event);
 static void HandleTrayMotionNotify(TrayType *tp, const XMotionEvent *event);
 
 static void ComputeTrayGeometry(TrayType *tp);
+static void GetRequestedTrayPosition(const TrayType *tp, const ScreenType *sp,
+                                     int *x, int *y);
+static void ComputeTrayPosition(TrayType *tp);
 static int ComputeMaxWidth(TrayType *tp);
 static int ComputeTotalWidth(TrayType *tp);
 static int ComputeMaxHeight(TrayType *tp);
@@ -105,6 +110,11 @@ void StartupTray(void)
                                   rootVisual, attrMask, &attr);
       SetAtomAtom(tp->window, ATOM_NET_WM_WINDOW_TYPE,
                   ATOM_NET_WM_WINDOW_TYPE_DOCK);
+      RegisterWindowHandler(tp->window, OWNER_TRAY, tp,
+                            ExposureMask | EnterWindowMask
+                            | ButtonPressMask | ButtonReleaseMask
+                            | PointerMotionMask,
+                            ProcessTrayEvent);
 
       if(settings.trayOpacity < UINT_MAX) {
          SetCardinalAtom(tp->window, ATOM_NET_WM_WINDOW_OPACITY,
@@ -185,6 +195,7 @@ void ShutdownTray(void)
             (cp->Destroy)(cp);
          }
       }
+      UnregisterWindow(tp->window);
       JXDestroyWindow(display, tp->window);
    }
 }
@@ -265,6 +276,7 @@ TrayComponentType *CreateTrayComponent(void)
    cp->width = 0;
    cp->height = 0;
    cp->grabbed = 0;
+   cp->fill = 0;
 
    cp->window = None;
    cp->pixmap = None;
@@ -394,33 +406,40 @@ char CheckVerticalFill(TrayType *tp)
    return 0;
 }
 
-/** Compute the size and position of a tray. */
-void ComputeTrayGeometry(TrayType *tp)
+/** Get the requested position of a tray.
+ * The requested coordinates (if provided) are screen-relative.
+ * This will compute x and y to be in root-window coordinates.
+ */
+void GetRequestedTrayPosition(const TrayType *tp, const ScreenType *sp,
+                              int *x, int *y)
 {
-   const ScreenType *sp = GetScreen(tp->screen);
-   TrayComponentType *cp;
-   int x, y;
-
-   /* Set requested position.
-    * The requested coordinates (if provided) are screen-relative.
-    * This will compute x and y to be in root-window coordinates.
-    */
-   x = 0;
-   y = 0;
+   *x = 0;
+   *y = 0;
    if(tp->halign == TALIGN_FIXED) {
-      x = tp->requestedX;
-      if(x < 0) {
-         x += sp->width + 1;
+      *x = tp->requestedX;
+      if(*x < 0) {
+         *x += sp->width + 1;
       }
    }
    if(tp->valign == TALIGN_FIXED) {
-      y = tp->requestedY;
-      if(y < 0) {
-         y += sp->height + 1;
+      *y = tp->requestedY;
+      if(*y < 0) {
+         *y += sp->height + 1;
       }
    }
-   x += sp->x;
-   y += sp->y;
+   *x += sp->x;
+   *y += sp->y;
+}
+
+/** Compute the size and position of a tray. */
+void ComputeTrayGeometry(TrayType *tp)
+{
+   const ScreenType *sp = GetScreen(tp->screen);
+   TrayComponentType *cp;
+   int x, y;
+
+   /* Set requested position. */
+   GetRequestedTrayPosition(tp, sp, &x, &y);
 
    /* Set requested sizes. */
    if(tp->requestedWidth >= 0) {
@@ -499,7 +518,17 @@ void ComputeTrayGeometry(TrayType *tp)
       }
    }
 
-   /* Compute the tray location. */
+   ComputeTrayPosition(tp);
+}
+
+/** Compute the location of a tray from its size and alignment. */
+void ComputeTrayPosition(TrayType *tp)
+{
+   const ScreenType *sp = GetScreen(tp->screen);
+   int x, y;
+
+   GetRequestedTrayPosition(tp, sp, &x, &y);
+
    switch(tp->valign) {
    case TALIGN_TOP:
       tp->y = sp->y;
@@ -641,35 +670,29 @@ void HideTray(TrayType *tp)
 }
 
 /** Process a tray event. */
-char ProcessTrayEvent(const XEvent *event)
+char ProcessTrayEvent(void *data, const XEvent *event)
 {
-   TrayType *tp;
-
-   for(tp = trays; tp; tp = tp->next) {
-      if(event->xany.window == tp->window) {
-         switch(event->type) {
-         case Expose:
-            HandleTrayExpose(tp, &event->xexpose);
-            return 1;
-         case EnterNotify:
-            HandleTrayEnterNotify(tp, &event->xcrossing);
-            return 1;
-         case ButtonPress:
-            HandleTrayButtonPress(tp, &event->xbutton);
-            return 1;
-         case ButtonRelease:
-            HandleTrayButtonRelease(tp, &event->xbutton);
-            return 1;
-         case MotionNotify:
-            HandleTrayMotionNotify(tp, &event->xmotion);
-            return 1;
-         default:
-            return 0;
-         }
-      }
+   TrayType *tp = (TrayType*)data;
+   Assert(event->xany.window == tp->window);
+   switch(event->type) {
+   case Expose:
+      HandleTrayExpose(tp, &event->xexpose);
+      return 1;
+   case EnterNotify:
+      HandleTrayEnterNotify(tp, &event->xcrossing);
+      return 1;
+   case ButtonPress:
+      HandleTrayButtonPress(tp, &event->xbutton);
+      return 1;
+   case ButtonRelease:
+      HandleTrayButtonRelease(tp, &event->xbutton);
+      return 1;
+   case MotionNotify:
+      HandleTrayMotionNotify(tp, &event->xmotion);
+      return 1;
+   default:
+      return 0;
    }
-
-   return 0;
 }
 
 /** Signal the tray (needed for autohide). */
@@ -858,6 +881,20 @@ void UpdateSpecificTray(const TrayType *tp, const TrayComponentType *cp)
    }
 }
 
+/** Update part of a component on a tray. */
+void UpdateSpecificTrayArea(const TrayType *tp, const TrayComponentType *cp,
+                            int x, int y, int width, int height)
+{
+   if(JUNLIKELY(shouldExit)) {
+      return;
+   }
+
+   if(cp->pixmap != None) {
+      JXCopyArea(display, cp->pixmap, tp->window, rootGC, x, y,
+                 width, height, cp->x + x, cp->y + y);
+   }
+}
+
 /** Layout tray components on a tray. */
 void LayoutTray(TrayType *tp, int *variableSize, int *variableRemainder)
 {
@@ -943,6 +980,11 @@ void ResizeTray(TrayType *tp)
       cp->y = yoffset;
       cp->screenx = tp->x + xoffset;
       cp->screeny = tp->y + yoffset;
+      if(tp->layout == LAYOUT_HORIZONTAL) {
+         cp->fill = cp->width == 0;
+      } else {
+         cp->fill = cp->height == 0;
+      }
 
       if(cp->Resize) {
          if(tp->layout == LAYOUT_HORIZONTAL) {
@@ -993,6 +1035,166 @@ void ResizeTray(TrayType *tp)
    }
 }
 
+/** Resize a component on a tray.
+ * The size change is absorbed by the component that fills the tray or
+ * by growing the tray. Components after the changed one are moved
+ * without being resized. The whole tray is laid out again if this is
+ * not possible.
+ */
+void ResizeTrayComponent(TrayComponentType *cp)
+{
+   TrayType *tp = cp->tray;
+   TrayComponentType *ip;
+   TrayComponentType *fill;
+   const char horizontal = tp->layout == LAYOUT_HORIZONTAL;
+   int crossSize, oldSize, newSize, delta;
+   int xoffset, yoffset;
+   int oldx, oldy;
+   char growTray;
+
+   Assert(cp);
+   Assert(tp);
+
+   if(JUNLIKELY(tp->window == None) || cp->fill) {
+      ResizeTray(tp);
+      return;
+   }
+
+   /* The tray must keep its size in the other direction. */
+   if(horizontal) {
+      crossSize = tp->height - TRAY_BORDER_SIZE * 2;
+   } else {
+      crossSize = tp->width - TRAY_BORDER_SIZE * 2;
+   }
+   if((horizontal && tp->requestedHeight == 0)
+      || (!horizontal && tp->requestedWidth == 0)) {
+      int maxSize = 0;
+      for(ip = tp->components; ip; ip = ip->next) {
+         maxSize = Max(maxSize, horizontal
+                       ? ip->requestedHeight : ip->requestedWidth);
+      }
+      if(maxSize == 0) {
+         maxSize = horizontal ? DEFAULT_TRAY_HEIGHT : DEFAULT_TRAY_WIDTH;
+      } else {
+         maxSize += TRAY_BORDER_SIZE * 2;
+      }
+      if(maxSize != crossSize + TRAY_BORDER_SIZE * 2) {
+         ResizeTray(tp);
+         return;
+      }
+   }
+
+   /* Let the component determine its new size. */
+   oldSize = horizontal ? cp->width : cp->height;
+   cp->width = cp->requestedWidth;
+   cp->height = cp->requestedHeight;
+   if(cp->SetSize) {
+      if(horizontal) {
+         (cp->SetSize)(cp, 0, crossSize);
+      } else {
+         (cp->SetSize)(cp, crossSize, 0);
+      }
+   }
+   newSize = horizontal ? cp->width : cp->height;
+   if(newSize <= 0) {
+      ResizeTray(tp);
+      return;
+   }
+   if(horizontal) {
+      cp->height = crossSize;
+   } else {
+      cp->width = crossSize;
+   }
+   delta = newSize - oldSize;
+   if(delta == 0) {
+      if(cp->Resize) {
+         (cp->Resize)(cp);
+      }
+      UpdateSpecificTray(tp, cp);
+      return;
+   }
+
+   /* Find the component to absorb the change. */
+   fill = NULL;
+   for(ip = tp->components; ip; ip = ip->next) {
+      if(ip->fill) {
+         if(fill) {
+            ResizeTray(tp);
+            return;
+         }
+         fill = ip;
+      }
+   }
+   growTray = 0;
+   if(fill) {
+      const int fillSize = (horizontal ? fill->width : fill->height) - delta;
+      if(fillSize < 1) {
+         ResizeTray(tp);
+         return;
+      }
+      if(horizontal) {
+         fill->width = fillSize;
+      } else {
+         fill->height = fillSize;
+      }
+   } else if((horizontal && tp->requestedWidth != 0)
+             || (!horizontal && tp->requestedHeight != 0)) {
+      ResizeTray(tp);
+      return;
+   } else {
+      if(horizontal) {
+         tp->width += delta;
+      } else {
+         tp->height += delta;
+      }
+      ComputeTrayPosition(tp);
+      growTray = 1;
+   }
+
+   /* Move components after the change. */
+   xoffset = TRAY_BORDER_SIZE;
+   yoffset = TRAY_BORDER_SIZE;
+   for(ip = tp->components; ip; ip = ip->next) {
+      oldx = ip->x;
+      oldy = ip->y;
+      ip->x = xoffset;
+      ip->y = yoffset;
+      ip->screenx = tp->x + xoffset;
+      ip->screeny = tp->y + yoffset;
+      if(ip == cp || ip == fill) {
+         if(ip->Resize) {
+            (ip->Resize)(ip);
+         }
+         oldx = -1;
+      }
+      if(ip->x != oldx || ip->y != oldy) {
+         if(ip->window != None) {
+            JXMoveWindow(display, ip->window, xoffset, yoffset);
+         }
+         if(!growTray) {
+            UpdateSpecificTray(tp, ip);
+         }
+      }
+      if(horizontal) {
+         xoffset += ip->width;
+      } else {
+         yoffset += ip->height;
+      }
+   }
+
+   if(growTray) {
+      JXMoveResizeWindow(display, tp->window, tp->x, tp->y,
+                         tp->width, tp->height);
+      DrawSpecificTray(tp);
+      if(tp->hidden) {
+         HideTray(tp);
+      }
+   }
+   if(fill) {
+      RequireTaskUpdate();
+   }
+}
+
 /** Draw the tray background on a drawable. */
 void ClearTrayDrawable(const TrayComponentType *cp)
 {
@@ -80,6 +80,7 @@ typedef struct TrayComponentType {
    int height;    /**< Actual height. */
 
    char grabbed;     /**< 1 if the mouse was grabbed by this component. */
+   char fill;        /**< 1 if the tray assigned the size (fills the tray). */
 
    Window window;    /**< Content (if a window, otherwise None). */
    Pixmap pixmap;    /**< Content (if a pixmap, otherwise None). */
@@ -214,11 +215,28 @@ void LowerTrays(void);
  */
 void UpdateSpecificTray(const TrayType *tp, const TrayComponentType *cp);
 
+/** Update part of a component on a tray.
+ * @param tp The tray containing the component.
+ * @param cp The component that needs updating.
+ * @param x The x-coordinate of the area relative to the component.
+ * @param y The y-coordinate of the area relative to the component.
+ * @param width The width of the area.
+ * @param height The height of the area.
+ */
+void UpdateSpecificTrayArea(const TrayType *tp, const TrayComponentType *cp,
+                            int x, int y, int width, int height);
+
 /** Resize a tray.
  * @param tp The tray to resize containing the new requested size information.
  */
 void ResizeTray(TrayType *tp);
 
+/** Resize a single component on a tray.
+ * This is faster than ResizeTray when only one component changed size.
+ * @param cp The component containing the new requested size information.
+ */
+void ResizeTrayComponent(TrayComponentType *cp);
+
 /** Draw the tray background on a drawable. */
 void ClearTrayDrawable(const TrayComponentType *cp);
 
@@ -232,12 +250,6 @@ TrayType *GetTrays(void);
  */
 unsigned int GetTrayCount(void);
 
-/** Process an event that may be for a tray.
- * @param event The event to process.
- * @return 1 if this event was for a tray, 0 otherwise.
- */
-char ProcessTrayEvent(const XEvent *event);
-
 /** Set whether auto-hide is enabled for a tray.
  * @param tp The tray.
  * @param autohide The auto-hide setting.
@@ -0,0 +1,223 @@
+/**
+ * @file winmap.c
+ *
+ * @brief Map from X windows to the JWM object that owns them.
+ *
+ * This is an open-addressing hash table with linear probing.
+ * Deletion shifts entries back so no tombstones are needed.
+ * Each entry may also carry an event handler so that events can be
+ * dispatched to the owning component with a single lookup.
+ *
+ */
+
+#include "jwm.h"
+#include "winmap.h"
+
+/** Initial table size (must be a power of 2). */
+#define INITIAL_MAP_SIZE 64
+
+typedef struct WindowMapEntry {
+   Window window;
+   void *data;
+   WindowEventHandler handler;
+   long mask;
+   WindowOwnerType owner;
+} WindowMapEntry;
+
+static WindowMapEntry *table = NULL;
+static unsigned int tableSize = 0;
+static unsigned int tableCount = 0;
+
+static unsigned int HashWindow(Window w);
+static void ResizeWindowMap(unsigned int size);
+static const WindowMapEntry *FindEntry(Window w);
+static long GetEventMask(int type);
+
+/** Destroy the window map. */
+void DestroyWindowMap(void)
+{
+   if(table) {
+      Release(table);
+      table = NULL;
+   }
+   tableSize = 0;
+   tableCount = 0;
+}
+
+/** Compute the bucket for a window.
+ * Window IDs from one X client differ only in the low bits and IDs from
+ * different clients differ only in the high bits, so mix both.
+ */
+unsigned int HashWindow(Window w)
+{
+   unsigned long h = (unsigned long)w;
+   h ^= h >> 16;
+   h *= 0x45D9F3BUL;
+   h ^= h >> 16;
+   return (unsigned int)h & (tableSize - 1);
+}
+
+/** Resize the table and reinsert all entries. */
+void ResizeWindowMap(unsigned int size)
+{
+   WindowMapEntry *old = table;
+   const unsigned int oldSize = tableSize;
+   unsigned int x;
+
+   table = Allocate(sizeof(WindowMapEntry) * size);
+   memset(table, 0, sizeof(WindowMapEntry) * size);
+   tableSize = size;
+
+   for(x = 0; x < oldSize; x++) {
+      if(old[x].window != None) {
+         unsigned int i = HashWindow(old[x].window);
+         while(table[i].window != None) {
+            i = (i + 1) & (tableSize - 1);
+         }
+         table[i] = old[x];
+      }
+   }
+   if(old) {
+      Release(old);
+   }
+}
+
+/** Register the owner of a window. */
+void RegisterWindow(Window w, WindowOwnerType owner, void *data)
+{
+   RegisterWindowHandler(w, owner, data, NoEventMask, NULL);
+}
+
+/** Register the owner of a window along with an event handler. */
+void RegisterWindowHandler(Window w, WindowOwnerType owner, void *data,
+                           long mask, WindowEventHandler handler)
+{
+   unsigned int i;
+
+   Assert(w != None);
+   Assert(owner != OWNER_NONE);
+
+   /* Keep the load factor at or below 1/2. */
+   if((tableCount + 1) * 2 > tableSize) {
+      ResizeWindowMap(tableSize ? tableSize * 2 : INITIAL_MAP_SIZE);
+   }
+
+   i = HashWindow(w);
+   while(table[i].window != None && table[i].window != w) {
+      i = (i + 1) & (tableSize - 1);
+   }
+   if(table[i].window == None) {
+      tableCount += 1;
+   }
+   table[i].window = w;
+   table[i].owner = owner;
+   table[i].data = data;
+   table[i].mask = handler ? mask : NoEventMask;
+   table[i].handler = handler;
+}
+
+/** Remove the owner registration for a window. */
+void UnregisterWindow(Window w)
+{
+   unsigned int i, j;
+
+   if(JUNLIKELY(tableCount == 0 || w == None)) {
+      return;
+   }
+
+   i = HashWindow(w);
+   while(table[i].window != w) {
+      if(table[i].window == None) {
+         return;
+      }
+      i = (i + 1) & (tableSize - 1);
+   }
+   tableCount -= 1;
+
+   /* Shift back any entries that were displaced past this slot. */
+   j = i;
+   for(;;) {
+      unsigned int k;
+      table[i].window = None;
+      for(;;) {
+         j = (j + 1) & (tableSize - 1);
+         if(table[j].window == None) {
+            return;
+         }
+         k = HashWindow(table[j].window);
+         /* Leave the entry if its home slot lies cyclically in (i, j]. */
+         if(i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+            continue;
+         }
+         break;
+      }
+      table[i] = table[j];
+      i = j;
+   }
+}
+
+/** Find the entry for a window. */
+const WindowMapEntry *FindEntry(Window w)
+{
+   unsigned int i;
+
+   if(JLIKELY(tableCount > 0 && w != None)) {
+      i = HashWindow(w);
+      while(table[i].window != None) {
+         if(table[i].window == w) {
+            return &table[i];
+         }
+         i = (i + 1) & (tableSize - 1);
+      }
+   }
+   return NULL;
+}
+
+/** Look up the owner of a window. */
+WindowOwnerType FindWindowOwner(Window w, void **data)
+{
+   const WindowMapEntry *ep = FindEntry(w);
+   if(ep) {
+      *data = ep->data;
+      return ep->owner;
+   }
+   *data = NULL;
+   return OWNER_NONE;
+}
+
+/** Get the X event mask that selects an event type.
+ * Event types not listed here are never dispatched to handlers.
+ */
+long GetEventMask(int type)
+{
+   switch(type) {
+   case KeyPress:          return KeyPressMask;
+   case KeyRelease:        return KeyReleaseMask;
+   case ButtonPress:       return ButtonPressMask;
+   case ButtonRelease:     return ButtonReleaseMask;
+   case MotionNotify:      return PointerMotionMask;
+   case EnterNotify:       return EnterWindowMask;
+   case LeaveNotify:       return LeaveWindowMask;
+   case FocusIn:
+   case FocusOut:          return FocusChangeMask;
+   case Expose:            return ExposureMask;
+   case DestroyNotify:
+   case UnmapNotify:
+   case MapNotify:
+   case ReparentNotify:
+   case ConfigureNotify:   return StructureNotifyMask;
+   case ResizeRequest:     return ResizeRedirectMask;
+   case PropertyNotify:    return PropertyChangeMask;
+   default:                return NoEventMask;
+   }
+}
+
+/** Pass an event to the handler registered for its window. */
+char DispatchWindowEvent(const XEvent *event)
+{
+   const WindowMapEntry *ep = FindEntry(event->xany.window);
+   if(ep && (ep->mask & GetEventMask(event->type))) {
+      return (ep->handler)(ep->data, event);
+   }
+   return 0;
+}
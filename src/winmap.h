@@ -0,0 +1,74 @@
+/**
+ * @file winmap.h
+ *
+ * @brief Map from X windows to the JWM object that owns them.
+ *
+ */
+
+#ifndef WINMAP_H
+#define WINMAP_H
+
+/** Enumeration of window owner types. */
+typedef unsigned char WindowOwnerType;
+#define OWNER_NONE      0  /**< Not a window known to JWM. */
+#define OWNER_CLIENT    1  /**< Client window (ClientNode). */
+#define OWNER_FRAME     2  /**< Client frame window (ClientNode). */
+#define OWNER_TRAY      3  /**< Tray window (TrayType). */
+#define OWNER_DOCK      4  /**< Docked system tray icon (DockNode). */
+#define OWNER_SWALLOW   5  /**< Swallowed window (TrayComponentType). */
+#define OWNER_MENU      6  /**< Menu window (Menu). */
+#define OWNER_DIALOG    7  /**< Confirm dialog window (ClientNode). */
+#define OWNER_POPUP     8  /**< Popup window (no data). */
+
+/** Handler for events on a registered window.
+ * @param data The owner object passed at registration.
+ * @param event The event.
+ * @return 1 if the event was handled, 0 otherwise.
+ */
+typedef char (*WindowEventHandler)(void *data, const XEvent *event);
+
+/*@{*/
+#define InitializeWindowMap() (void)(0)
+#define StartupWindowMap()    (void)(0)
+#define ShutdownWindowMap()   (void)(0)
+void DestroyWindowMap(void);
+/*@}*/
+
+/** Register the owner of a window.
+ * Any existing registration for the window is replaced.
+ * @param w The window.
+ * @param owner The owner type.
+ * @param data The owner object.
+ */
+void RegisterWindow(Window w, WindowOwnerType owner, void *data);
+
+/** Register the owner of a window along with an event handler.
+ * Any existing registration for the window is replaced.
+ * @param w The window.
+ * @param owner The owner type.
+ * @param data The owner object (passed to the handler).
+ * @param mask The X event mask of events to pass to the handler.
+ * @param handler The event handler.
+ */
+void RegisterWindowHandler(Window w, WindowOwnerType owner, void *data,
+                           long mask, WindowEventHandler handler);
+
+/** Remove the owner registration for a window.
+ * @param w The window (it is not an error if the window is not registered).
+ */
+void UnregisterWindow(Window w);
+
+/** Look up the owner of a window.
+ * @param w The window.
+ * @param data Set to the owner object (NULL if not registered).
+ * @return The owner type (OWNER_NONE if not registered).
+ */
+WindowOwnerType FindWindowOwner(Window w, void **data);
+
+/** Pass an event to the handler registered for its window.
+ * @param event The event.
+ * @return 1 if the event was handled, 0 otherwise.
+ */
+char DispatchWindowEvent(const XEvent *event);
+
+#endif /* WINMAP_H */